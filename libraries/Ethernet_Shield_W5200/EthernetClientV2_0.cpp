@@ -14,10 +14,10 @@ extern "C" {
 
 uint16_t EthernetClient::_srcport = 1024;
 
-EthernetClient::EthernetClient() : _sock(MAX_SOCK_NUM) {
+EthernetClient::EthernetClient() : _sock(MAX_SOCK_NUM), _deadline(0), _timedOut(0) {
 }
 
-EthernetClient::EthernetClient(uint8_t sock) : _sock(sock) {
+EthernetClient::EthernetClient(uint8_t sock) : _sock(sock), _deadline(0), _timedOut(0) {
 }
 
 int EthernetClient::connect(const char* host, uint16_t port) {
@@ -36,6 +36,24 @@ int EthernetClient::connect(const char* host, uint16_t port) {
 }
 
 int EthernetClient::connect(IPAddress ip, uint16_t port) {
+  _timedOut = 0;
+  if (!beginConnect(ip, port))
+    return 0;
+
+  while (connecting()) {
+    if (expired()) {
+      close(_sock);
+      _sock = MAX_SOCK_NUM;
+      _timedOut = 1;
+      return 0;
+    }
+    delay(1);
+  }
+
+  return _sock != MAX_SOCK_NUM;
+}
+
+int EthernetClient::beginConnect(IPAddress ip, uint16_t port) {
   if (_sock != MAX_SOCK_NUM)
     return 0;
 
@@ -59,15 +77,33 @@ int EthernetClient::connect(IPAddress ip, uint16_t port) {
     return 0;
   }
 
-  while (status() != SnSR::ESTABLISHED) {
-    delay(1);
-    if (status() == SnSR::CLOSED) {
-      _sock = MAX_SOCK_NUM;
-      return 0;
-    }
+  return 1;
+}
+
+uint8_t EthernetClient::connecting() {
+  if (_sock == MAX_SOCK_NUM)
+    return 0;
+
+  uint8_t s = status();
+  if (s == SnSR::CLOSED) {
+    // Connection refused or timed out
+    _sock = MAX_SOCK_NUM;
+    return 0;
   }
 
-  return 1;
+  return s == SnSR::INIT || s == SnSR::SYNSENT || s == SnSR::SYNRECV;
+}
+
+void EthernetClient::setDeadline(unsigned long deadline) {
+  _deadline = deadline;
+}
+
+uint8_t EthernetClient::timedOut() {
+  return _timedOut;
+}
+
+uint8_t EthernetClient::expired() {
+  return _deadline != 0 && (long)(millis() - _deadline) >= 0;
 }
 
 size_t EthernetClient::write(uint8_t b) {
@@ -79,7 +115,9 @@ size_t EthernetClient::write(const uint8_t *buf, size_t size) {
     setWriteError();
     return 0;
   }
-  if (!send(_sock, buf, size)) {
+  _timedOut = 0;
+  if (!send(_sock, buf, size, _deadline)) {
+    _timedOut = expired();
     setWriteError();
     return 0;
   }
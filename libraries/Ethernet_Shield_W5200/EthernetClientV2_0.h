@@ -14,6 +14,14 @@ public:
   uint8_t status();
   virtual int connect(IPAddress ip, uint16_t port);
   virtual int connect(const char *host, uint16_t port);
+  // Start connecting without waiting for the TCP handshake to complete.
+  // Poll connecting() until it returns 0, then check connected().
+  int beginConnect(IPAddress ip, uint16_t port);
+  uint8_t connecting();
+  // Give up blocking connect and write calls at the millis() deadline
+  // (0 for none).  timedOut() reports whether the last call gave up.
+  void setDeadline(unsigned long deadline);
+  uint8_t timedOut();
   virtual size_t write(uint8_t);
   virtual size_t write(const uint8_t *buf, size_t size);
   virtual int available();
@@ -32,6 +40,10 @@ public:
 private:
   static uint16_t _srcport;
   uint8_t _sock;
+  unsigned long _deadline;
+  uint8_t _timedOut;
+
+  uint8_t expired();
 };
 
 #endif
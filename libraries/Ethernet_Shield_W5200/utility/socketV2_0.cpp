@@ -1,8 +1,18 @@
 #include "w5200.h"
 #include "socketV2_0.h"
 
+#include "Arduino.h"
+
 static uint16_t local_port;
 
+/**
+ * @brief	Check whether the millis() deadline for a blocking call has passed.  A deadline of 0 never expires.
+ */
+static uint8_t expired(unsigned long deadline)
+{
+  return deadline != 0 && (long)(millis() - deadline) >= 0;
+}
+
 /**
  * @brief	This Socket function initialize the channel in perticular mode, and set the port and wait for W5100 done it.
  * @return 	1 for success else 0.
@@ -91,9 +101,10 @@ void disconnect(SOCKET s)
 
 /**
  * @brief	This function used to send the data in TCP mode
+ * 		Gives up and closes the socket if the data is not sent by the deadline.
  * @return	1 for success else 0.
  */
-uint16_t send(SOCKET s, const uint8_t * buf, uint16_t len)
+uint16_t send(SOCKET s, const uint8_t * buf, uint16_t len, unsigned long deadline)
 {
   uint8_t status=0;
   uint16_t ret=0;
@@ -114,6 +125,11 @@ uint16_t send(SOCKET s, const uint8_t * buf, uint16_t len)
       ret = 0; 
       break;
     }
+    if (expired(deadline))
+    {
+      close(s);
+      return 0;
+    }
   } 
   while (freesize < ret);
 
@@ -125,7 +141,7 @@ uint16_t send(SOCKET s, const uint8_t * buf, uint16_t len)
   while ( (W5100.readSnIR(s) & SnIR::SEND_OK) != SnIR::SEND_OK ) 
   {
     /* m2008.01 [bj] : reduce code */
-    if ( W5100.readSnSR(s) == SnSR::CLOSED )
+    if ( W5100.readSnSR(s) == SnSR::CLOSED || expired(deadline) )
     {
       close(s);
       return 0;
@@ -8,7 +8,7 @@ extern void close(SOCKET s); // Close socket
 extern uint8_t connect(SOCKET s, uint8_t * addr, uint16_t port); // Establish TCP connection (Active connection)
 extern void disconnect(SOCKET s); // disconnect the connection
 extern uint8_t listen(SOCKET s);	// Establish TCP connection (Passive connection)
-extern uint16_t send(SOCKET s, const uint8_t * buf, uint16_t len); // Send data (TCP)
+extern uint16_t send(SOCKET s, const uint8_t * buf, uint16_t len, unsigned long deadline = 0); // Send data (TCP), giving up at the millis() deadline (0 for none)
 extern int16_t recv(SOCKET s, uint8_t * buf, int16_t len);	// Receive data (TCP)
 extern uint16_t peek(SOCKET s, uint8_t *buf);
 extern uint16_t sendto(SOCKET s, const uint8_t * buf, uint16_t len, uint8_t * addr, uint16_t port); // Send data (UDP/IP RAW)
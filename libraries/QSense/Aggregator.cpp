@@ -0,0 +1,346 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "Aggregator.h"
+
+#if defined( ARDUINO )
+#include "FlashString.h"
+#else
+#include <FlashString.h>
+#endif
+
+namespace qsense
+{
+  namespace data
+  {
+    /// Suffixes of the keys of the statistics, in the order of the flags
+    const char suffixes[][7] PROGMEM =
+    {
+      ".count", ".min", ".max", ".mean", ".sum", ".last"
+    };
+
+    const uint8_t numberOfSuffixes = sizeof( suffixes ) / sizeof( suffixes[0] );
+
+    /// Index of the slide interval containing the timestamp, rounded down
+    int64_t paneOf( int64_t timestamp, uint32_t slide )
+    {
+      if ( timestamp >= 0 ) return timestamp / slide;
+      return -( ( -timestamp - 1 ) / slide ) - 1;
+    }
+  }
+}
+
+using qsense::QString;
+using qsense::Reading;
+using qsense::Symbol;
+using qsense::Aggregator;
+
+
+Aggregator::Pane::Pane() : sum( 0 ), count( 0 ), minimum( 0 ), maximum( 0 ) {}
+
+
+void Aggregator::Pane::add( float value )
+{
+  if ( count == 0 || value < minimum ) minimum = value;
+  if ( count == 0 || value > maximum ) maximum = value;
+  sum += value;
+  ++count;
+}
+
+
+void Aggregator::Pane::merge( const Pane& pane )
+{
+  if ( pane.count == 0 ) return;
+
+  if ( count == 0 || pane.minimum < minimum ) minimum = pane.minimum;
+  if ( count == 0 || pane.maximum > maximum ) maximum = pane.maximum;
+  sum += pane.sum;
+  count += pane.count;
+}
+
+
+Aggregator::Aggregator( uint32_t window, uint32_t s, uint8_t stats ) :
+  windows(), slide( s ), low( 0 ), high( 0 ), panes( 1 ), statistics( stats ),
+  numberOfPercents( 0 ), cursor( 0 ), windowCursor( 0 )
+{
+  if ( window == 0 ) window = 1;
+  if ( slide == 0 || slide >= window )
+  {
+    slide = window;
+    return;
+  }
+
+  // Widen the slide rather than keep more panes than allowed
+  const uint32_t maximum = QSENSE_AGGREGATE_PANES;
+  if ( ( window + slide - 1 ) / slide > maximum ) slide = ( window + maximum - 1 ) / maximum;
+  panes = uint8_t( ( window + slide - 1 ) / slide );
+}
+
+
+bool Aggregator::setRange( float l, float h )
+{
+  if ( ! windows.empty() || ! ( h > l ) ) return false;
+
+  low = l;
+  high = h;
+  return true;
+}
+
+
+bool Aggregator::addPercentile( uint8_t percent )
+{
+  if ( ! windows.empty() || numberOfPercents >= maxPercentiles ) return false;
+
+  percents[numberOfPercents++] = ( percent > 100 ) ? 100 : percent;
+  return true;
+}
+
+
+bool Aggregator::add( const Reading& reading )
+{
+  if ( reading.getType() == Reading::Text ) return false;
+
+  Window* window = find( reading.getKeySymbol() );
+  if ( window == NULL )
+  {
+    if ( ! create( reading.getKeySymbol() ) ) return false;
+    window = &windows.back();
+    window->pane = data::paneOf( reading.getTimestamp(), slide );
+  }
+
+  advance( *window, data::paneOf( reading.getTimestamp(), slide ) );
+
+  const float value = reading.getFloat();
+  window->panes[window->current].add( value );
+  window->last = value;
+
+  if ( ! window->buckets.empty() )
+  {
+    const float width = ( high - low ) / QSENSE_AGGREGATE_BUCKETS;
+    int32_t bucket = QSENSE_AGGREGATE_BUCKETS - 1;
+    if ( value < high ) bucket = ( value > low ) ? int32_t( ( value - low ) / width ) : 0;
+    if ( bucket >= QSENSE_AGGREGATE_BUCKETS ) bucket = QSENSE_AGGREGATE_BUCKETS - 1;
+
+    uint16_t& counter = window->buckets[window->current * QSENSE_AGGREGATE_BUCKETS + bucket];
+    if ( counter < 0xFFFF ) ++counter;
+  }
+
+  return true;
+}
+
+
+bool Aggregator::poll( int64_t now )
+{
+  const int64_t pane = data::paneOf( now, slide );
+  for ( std::size_t i = 0; i < windows.size(); ++i ) advance( windows[i], pane );
+  return ready();
+}
+
+
+bool Aggregator::ready() const
+{
+  for ( std::size_t i = 0; i < windows.size(); ++i )
+  {
+    if ( windows[i].closed ) return true;
+  }
+
+  return false;
+}
+
+
+bool Aggregator::next( Reading& reading )
+{
+  while ( windowCursor < windows.size() )
+  {
+    Window& window = windows[windowCursor];
+    if ( window.closed && cursor < window.names.size() )
+    {
+      const uint8_t index = cursor++;
+      if ( index == 0 && ( statistics & Count ) )
+      {
+        reading = Reading( window.names[index], long( window.count ), window.closedAt );
+      }
+      else reading = Reading( window.names[index], window.results[index], window.closedAt );
+      return true;
+    }
+
+    window.closed = false;
+    cursor = 0;
+    ++windowCursor;
+  }
+
+  windowCursor = 0;
+  return false;
+}
+
+
+void Aggregator::clear()
+{
+  windows.clear();
+  cursor = 0;
+  windowCursor = 0;
+}
+
+
+Aggregator::Window* Aggregator::find( const Symbol& key )
+{
+  for ( std::size_t i = 0; i < windows.size(); ++i )
+  {
+    if ( windows[i].key == key ) return &windows[i];
+  }
+
+  return NULL;
+}
+
+
+bool Aggregator::create( const Symbol& key )
+{
+  if ( windows.size() >= QSENSE_AGGREGATE_KEYS || ! key.isValid() ) return false;
+
+  Window window;
+  window.key = key;
+
+  for ( uint8_t i = 0; i < data::numberOfSuffixes; ++i )
+  {
+    if ( ( statistics & ( 1 << i ) ) == 0 ) continue;
+
+    const Symbol name( key.str() + qsense::FlashString( data::suffixes[i] ).toString() );
+    if ( ! name.isValid() ) return false;
+    window.names.push_back( name );
+  }
+
+  if ( high > low )
+  {
+    for ( uint8_t i = 0; i < numberOfPercents; ++i )
+    {
+      char suffix[5] = { '.', 'p' };
+      uint8_t length = 2;
+      if ( percents[i] >= 100 ) suffix[length++] = '1';
+      if ( percents[i] >= 10 ) suffix[length++] = char( '0' + ( percents[i] / 10 ) % 10 );
+      suffix[length++] = char( '0' + percents[i] % 10 );
+
+      const Symbol name( key.str() + QString( suffix, length ) );
+      if ( ! name.isValid() ) return false;
+      window.names.push_back( name );
+    }
+
+    if ( numberOfPercents > 0 ) window.buckets.resize( panes * QSENSE_AGGREGATE_BUCKETS, 0 );
+  }
+
+  window.results.resize( window.names.size(), 0.0f );
+  window.panes.resize( panes );
+  window.pane = 0;
+  window.closedAt = 0;
+  window.count = 0;
+  window.last = 0;
+  window.current = 0;
+  window.closed = false;
+
+  windows.push_back( window );
+  return true;
+}
+
+
+void Aggregator::advance( Window& window, int64_t pane )
+{
+  if ( pane <= window.pane ) return;
+
+  close( window );
+
+  // Clear the panes moved over, at most once around the ring
+  const int64_t steps = pane - window.pane;
+  const uint8_t count = ( steps < panes ) ? uint8_t( steps ) : panes;
+  for ( uint8_t i = 0; i < count; ++i )
+  {
+    window.current = uint8_t( ( window.current + 1 ) % panes );
+    window.panes[window.current] = Pane();
+
+    if ( window.buckets.empty() ) continue;
+    for ( uint8_t b = 0; b < QSENSE_AGGREGATE_BUCKETS; ++b )
+    {
+      window.buckets[window.current * QSENSE_AGGREGATE_BUCKETS + b] = 0;
+    }
+  }
+
+  window.pane = pane;
+}
+
+
+void Aggregator::close( Window& window )
+{
+  Pane total;
+  for ( uint8_t i = 0; i < panes; ++i ) total.merge( window.panes[i] );
+  if ( total.count == 0 ) return;
+
+  uint8_t index = 0;
+  if ( statistics & Count ) ++index;
+  if ( statistics & Minimum ) window.results[index++] = total.minimum;
+  if ( statistics & Maximum ) window.results[index++] = total.maximum;
+  if ( statistics & Mean ) window.results[index++] = float( total.sum / total.count );
+  if ( statistics & Sum ) window.results[index++] = float( total.sum );
+  if ( statistics & Last ) window.results[index++] = window.last;
+
+  if ( ! window.buckets.empty() )
+  {
+    // Sum the histograms of the panes once for all the percentiles
+    std::vector<uint16_t> counts( QSENSE_AGGREGATE_BUCKETS, 0 );
+    for ( std::size_t i = 0; i < window.buckets.size(); ++i )
+    {
+      uint16_t& counter = counts[i % QSENSE_AGGREGATE_BUCKETS];
+      counter = ( uint32_t( counter ) + window.buckets[i] > 0xFFFF ) ?
+        0xFFFF : uint16_t( counter + window.buckets[i] );
+    }
+
+    for ( uint8_t i = 0; i < numberOfPercents; ++i )
+    {
+      window.results[index++] = percentile( counts, total, percents[i] );
+    }
+  }
+
+  // A collection in progress restarts with the new statistics
+  if ( windowCursor < windows.size() && &windows[windowCursor] == &window ) cursor = 0;
+
+  window.count = total.count;
+  window.closedAt = ( window.pane + 1 ) * int64_t( slide );
+  window.closed = true;
+}
+
+
+float Aggregator::percentile( const std::vector<uint16_t>& counts,
+    const Pane& total, uint8_t percent ) const
+{
+  uint32_t sum = 0;
+  for ( uint8_t i = 0; i < QSENSE_AGGREGATE_BUCKETS; ++i ) sum += counts[i];
+
+  const float rank = sum * ( percent / 100.0f );
+  const float width = ( high - low ) / QSENSE_AGGREGATE_BUCKETS;
+
+  uint32_t below = 0;
+  for ( uint8_t i = 0; i < QSENSE_AGGREGATE_BUCKETS; ++i )
+  {
+    if ( counts[i] == 0 || below + counts[i] < rank )
+    {
+      below += counts[i];
+      continue;
+    }
+
+    // Interpolate within the bucket, bounded by the values seen
+    float value = low + width * ( i + ( rank - below ) / counts[i] );
+    if ( value < total.minimum ) value = total.minimum;
+    if ( value > total.maximum ) value = total.maximum;
+    return value;
+  }
+
+  return total.maximum;
+}
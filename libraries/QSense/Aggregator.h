@@ -0,0 +1,251 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef QSENSE_AGGREGATOR_H
+#define QSENSE_AGGREGATOR_H
+
+#if defined( ARDUINO )
+#include "QSense.h"
+#include "Reading.h"
+#include "Symbol.h"
+#include "../StandardCplusplus/vector"
+#else
+#include <QSense.h>
+#include <Reading.h>
+#include <Symbol.h>
+#include <vector>
+#endif
+
+#ifndef QSENSE_AGGREGATE_KEYS
+// Maximum number of reading keys aggregated
+#if defined( ARDUINO )
+#define QSENSE_AGGREGATE_KEYS 4
+#else
+#define QSENSE_AGGREGATE_KEYS 64
+#endif
+#endif
+
+#ifndef QSENSE_AGGREGATE_PANES
+// Maximum number of panes a sliding window is divided into
+#if defined( ARDUINO )
+#define QSENSE_AGGREGATE_PANES 4
+#else
+#define QSENSE_AGGREGATE_PANES 60
+#endif
+#endif
+
+#ifndef QSENSE_AGGREGATE_BUCKETS
+// Number of histogram buckets from which percentiles are estimated
+#if defined( ARDUINO )
+#define QSENSE_AGGREGATE_BUCKETS 8
+#else
+#define QSENSE_AGGREGATE_BUCKETS 64
+#endif
+#endif
+
+namespace qsense
+{
+  /**
+   * @brief Summarises the readings of each key over a window of time, so
+   * that only the statistics need be published.
+   *
+   * Readings are added in place of adding them to an event.  Each key has
+   * its own window, aligned on multiples of the slide interval since the
+   * epoch, and the statistics selected are kept in memory that is fixed
+   * once the first reading of the key is added.  When a reading or
+   * {@link #poll} moves past the end of a window, the window is closed and
+   * its statistics are added to an event by {@link #collect} as readings
+   * keyed by the reading key with a suffix (\c .count, \c .min, \c .max,
+   * \c .mean, \c .sum, \c .last and \c .p<percent>), timestamped at the end
+   * of the window:
+   *
+   * \code
+   * Aggregator aggregator( 60000 );   // One minute tumbling windows
+   * aggregator.add( Reading( "temperature", sensor.read() ) );
+   * if ( aggregator.poll() )
+   * {
+   *   Event event;
+   *   aggregator.collect( event );
+   *   client.publish( event );
+   * }
+   * \endcode
+   *
+   * Each statistic reported is a reading key of its own, interned as a
+   * {@link Symbol} when the first reading of the key is added, so that
+   * \c QSENSE_SYMBOLS must allow for every key aggregated times the
+   * number of statistics and percentiles selected.
+   *
+   * A sliding window is divided into panes of the slide interval, and
+   * closes at the end of each pane.  Percentiles are estimated from a
+   * histogram of \c QSENSE_AGGREGATE_BUCKETS buckets over the range set
+   * with {@link #setRange}, interpolated within the bucket.
+   *
+   * Windows that end without a reading or poll during the following pane
+   * are not reported, apart from the most recent, and a window that closes
+   * before the previous one was collected replaces it.  Readings older
+   * than the current pane are counted in the current pane.
+   */
+  class Aggregator
+  {
+  public:
+    /// The statistics that may be reported for a window.
+    enum Statistic
+    {
+      Count = 0x01, Minimum = 0x02, Maximum = 0x04, Mean = 0x08, Sum = 0x10,
+      Last = 0x20
+    };
+
+    /// Maximum number of percentiles reported.
+    static const uint8_t maxPercentiles = 4;
+
+    /**
+     * @brief Create a new aggregator.
+     * @param window The length of the window in milli seconds.
+     * @param slide The interval in milli seconds at which a sliding window
+     *   advances, or \c 0 for tumbling windows.  Increased if the window is
+     *   more than \c QSENSE_AGGREGATE_PANES slides, and the window rounded
+     *   up to a whole number of slides.
+     * @param statistics The {@link Statistic}s to report, or'ed together.
+     */
+    Aggregator( uint32_t window, uint32_t slide = 0,
+        uint8_t statistics = Count | Minimum | Maximum | Mean );
+
+    /// Destructor.  No actions required.
+    ~Aggregator() {}
+
+    /**
+     * @brief Set the range of values over which percentiles are estimated.
+     * Values outside the range are counted in the first or last bucket.
+     * Must be set before the first reading is added.
+     * @return Returns \c false if readings were added already, or the
+     *   range is empty.
+     */
+    bool setRange( float low, float high );
+
+    /**
+     * @brief Report the specified percentile of each window.  Must be
+     * requested before the first reading is added, and is only reported
+     * if a range is set with {@link #setRange}.
+     * @param percent The percentile, between \c 0 and \c 100.
+     * @return Returns \c false if readings were added already, or
+     *   \c maxPercentiles percentiles were requested already.
+     */
+    bool addPercentile( uint8_t percent );
+
+    /**
+     * @brief Add the reading to the window for its key.
+     * @return Returns \c false if the reading was not aggregated, as it
+     *   holds a string, \c QSENSE_AGGREGATE_KEYS keys are aggregated
+     *   already, or the keys of its statistics could not be interned.
+     *   Add the reading to the event directly instead.
+     */
+    bool add( const Reading& reading );
+
+    /**
+     * @brief Close the windows that have ended.
+     * @param now The milli seconds since UNIX epoch.
+     * @return Returns \c true if any closed windows are waiting to be
+     *   collected.
+     */
+    bool poll( int64_t now = qsense::net::DateTime::singleton().currentTimeMillis() );
+
+    /// Return \c true if any closed windows are waiting to be collected.
+    bool ready() const;
+
+    /**
+     * @brief Remove the next statistic of the closed windows.
+     * @param reading Set to the statistic.
+     * @return Returns \c false if there are none.
+     */
+    bool next( Reading& reading );
+
+    /**
+     * @brief Add the statistics of all the closed windows to the event.
+     * @param event An {@link Event}, {@link StaticEvent} or
+     *   {@link ArenaEvent}.
+     * @return The number of readings added.
+     */
+    template <typename E>
+    std::size_t collect( E& event )
+    {
+      std::size_t count = 0;
+      Reading reading;
+      while ( next( reading ) )
+      {
+        event.add( reading );
+        ++count;
+      }
+
+      return count;
+    }
+
+    /// Return the number of keys aggregated.
+    std::size_t numberOfKeys() const { return windows.size(); }
+
+    /// Discard all keys and windows.  The configuration is retained.
+    void clear();
+
+  private:
+    /// The statistics of the readings within one slide interval.
+    struct Pane
+    {
+      Pane();
+      void add( float value );
+      void merge( const Pane& pane );
+
+      double sum;
+      uint32_t count;
+      float minimum;
+      float maximum;
+    };
+
+    /// The panes of one key, and the statistics of its closed window.
+    struct Window
+    {
+      Symbol key;
+      std::vector<Symbol> names;
+      std::vector<float> results;
+      std::vector<Pane> panes;
+      std::vector<uint16_t> buckets;
+      int64_t pane;
+      int64_t closedAt;
+      uint32_t count;
+      float last;
+      uint8_t current;
+      bool closed;
+    };
+
+    Window* find( const Symbol& key );
+    bool create( const Symbol& key );
+    void advance( Window& window, int64_t pane );
+    void close( Window& window );
+    float percentile( const std::vector<uint16_t>& counts, const Pane& total,
+      uint8_t percent ) const;
+
+  private:
+    std::vector<Window> windows;
+    uint32_t slide;
+    float low;
+    float high;
+    uint8_t panes;
+    uint8_t statistics;
+    uint8_t percents[maxPercentiles];
+    uint8_t numberOfPercents;
+    uint8_t cursor;
+    uint8_t windowCursor;
+  };
+
+} // namespace qsense
+
+#endif // QSENSE_AGGREGATOR_H
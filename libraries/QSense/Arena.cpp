@@ -0,0 +1,44 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "Arena.h"
+
+using qsense::Arena;
+
+
+Arena::Arena( void* b, std::size_t s ) : block( static_cast<char*>( b ) ),
+  size( s ), used( 0 ), last( 0 ), highWater( 0 ) {}
+
+
+void* Arena::allocate( std::size_t bytes )
+{
+  const std::size_t start = ( used + alignment - 1 ) & ~( alignment - 1 );
+  if ( start > size || bytes > size - start ) return NULL;
+
+  last = start;
+  used = start + bytes;
+  if ( used > highWater ) highWater = used;
+  return block + start;
+}
+
+
+bool Arena::extend( void* ptr, std::size_t bytes )
+{
+  if ( ptr != block + last || used == 0 ) return false;
+  if ( bytes > size - last ) return false;
+
+  used = last + bytes;
+  if ( used > highWater ) highWater = used;
+  return true;
+}
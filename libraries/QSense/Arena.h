@@ -0,0 +1,107 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef QSENSE_ARENA_H
+#define QSENSE_ARENA_H
+
+#if defined( ARDUINO )
+#include "QSense.h"
+#else
+#include <QSense.h>
+#endif
+
+namespace qsense
+{
+  /**
+   * @brief A bump allocator over a single caller supplied block of memory.
+   *
+   * Allocations are carved off the block in order and never freed
+   * individually.  {@link #reset} releases everything at once by
+   * rewinding to the start of the block, so a sequence of allocations that
+   * is repeated (such as building an event for every sample) reuses the
+   * same memory instead of fragmenting the heap.  Destructors are not run,
+   * so only objects that own no other memory should be placed in an arena.
+   *
+   * The most memory ever in use is recorded, to size the block:
+   *
+   * \code
+   * static char block[256];
+   * qsense::Arena arena( block, sizeof( block ) );
+   * void* ptr = arena.allocate( 24 );
+   * arena.reset();
+   * std::cout << arena.getHighWater() << std::endl;
+   * \endcode
+   */
+  class Arena
+  {
+  public:
+    /// Alignment of the allocations, none required on AVR.
+#if defined( __AVR__ )
+    static const std::size_t alignment = 1;
+#else
+    static const std::size_t alignment = 8;
+#endif
+
+    /**
+     * @brief Create an arena over the specified block.
+     * @param block The memory to allocate from.  Must outlive the arena,
+     *   and be aligned to \c alignment bytes.
+     * @param size The size of the block in bytes.
+     */
+    Arena( void* block, std::size_t size );
+
+    /// Allocate the specified number of bytes.  Returns \c NULL if the
+    /// block does not have enough space left.
+    void* allocate( std::size_t bytes );
+
+    /**
+     * @brief Grow the most recent allocation in place.
+     * @param ptr The memory returned by the most recent {@link #allocate}.
+     * @param bytes The new size of the allocation.
+     * @return Returns \c false if \c ptr is not the most recent allocation,
+     *   or the block does not have enough space left.
+     */
+    bool extend( void* ptr, std::size_t bytes );
+
+    /// Release all allocations.
+    void reset()
+    {
+      used = 0;
+      last = 0;
+    }
+
+    /// Return the size of the block in bytes.
+    std::size_t getSize() const { return size; }
+
+    /// Return the number of bytes allocated since the last {@link #reset}.
+    std::size_t getUsed() const { return used; }
+
+    /// Return the most bytes allocated at any time.
+    std::size_t getHighWater() const { return highWater; }
+
+  private:
+    Arena( const Arena& );
+    Arena& operator = ( const Arena& );
+
+  private:
+    char* block;
+    std::size_t size;
+    std::size_t used;
+    std::size_t last;
+    std::size_t highWater;
+  };
+
+} // namespace qsense
+
+#endif // QSENSE_ARENA_H
@@ -0,0 +1,149 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "ArenaEvent.h"
+
+#if defined( ARDUINO )
+#include "../StandardCplusplus/cstring"
+#include "../StandardCplusplus/new"
+#else
+#include <cstring>
+#include <new>
+#endif
+
+using qsense::ArenaEvent;
+using qsense::Reading;
+
+
+ArenaEvent::ArenaEvent( qsense::Arena& a ) : EventBase(), arena( a ),
+  readings( NULL ), tags( NULL ), keyTags( NULL )
+{
+  clear();
+}
+
+
+ArenaEvent::ArenaEvent( qsense::Arena& a, const qsense::Location& loc ) :
+  EventBase( loc ), arena( a ), readings( NULL ), tags( NULL ), keyTags( NULL )
+{
+  clear();
+}
+
+
+ArenaEvent& ArenaEvent::add( const Reading& reading )
+{
+  if ( reading.getType() == Reading::Text || ! reading.getKeySymbol().isValid() ||
+      ! append( readings, readingCount, readingCapacity, reading ) )
+  {
+    truncated = true;
+  }
+
+  return *this;
+}
+
+
+ArenaEvent& ArenaEvent::addTag( const char* tag, std::size_t length )
+{
+  const char* text = copy( tag, length );
+  if ( text == NULL || ! append( tags, tagCount, tagCapacity, text ) ) truncated = true;
+  return *this;
+}
+
+
+ArenaEvent& ArenaEvent::addKeyTag( const char* key, std::size_t keyLength,
+    const char* tag, std::size_t tagLength )
+{
+  const char* text = copy( tag, tagLength );
+  if ( text == NULL )
+  {
+    truncated = true;
+    return *this;
+  }
+
+  for ( uint8_t i = 0; i < keyTagCount; ++i )
+  {
+    KeyTags& kt = keyTags[i];
+    if ( strncmp( kt.key, key, keyLength ) != 0 || kt.key[keyLength] != 0 ) continue;
+
+    if ( ! append( kt.tags, kt.count, kt.capacity, text ) ) truncated = true;
+    return *this;
+  }
+
+  KeyTags kt;
+  kt.key = copy( key, keyLength );
+  kt.tags = NULL;
+  kt.count = 0;
+  kt.capacity = 0;
+
+  if ( kt.key == NULL || ! append( kt.tags, kt.count, kt.capacity, text ) ||
+      ! append( keyTags, keyTagCount, keyTagCapacity, kt ) )
+  {
+    truncated = true;
+  }
+
+  return *this;
+}
+
+
+void ArenaEvent::clear()
+{
+  // Readings held here own no heap memory, nothing needs to be destroyed
+  arena.reset();
+
+  readings = NULL;
+  tags = NULL;
+  keyTags = NULL;
+  readingCount = readingCapacity = 0;
+  tagCount = tagCapacity = 0;
+  keyTagCount = keyTagCapacity = 0;
+  truncated = false;
+}
+
+
+const char* ArenaEvent::copy( const char* text, std::size_t length )
+{
+  char* data = static_cast<char*>( arena.allocate( length + 1 ) );
+  if ( data == NULL ) return NULL;
+
+  memcpy( data, text, length );
+  data[length] = 0;
+  return data;
+}
+
+
+template <typename T>
+bool ArenaEvent::append( T*& array, uint8_t& count, uint8_t& capacity, const T& value )
+{
+  if ( count == capacity )
+  {
+    if ( capacity == 0xFF ) return false;
+    const uint8_t size = ( capacity == 0 ) ? 4 : ( capacity > 0x7F ) ? 0xFF : capacity * 2;
+
+    // Grow in place while the array is the most recent allocation,
+    // otherwise copy it and abandon the old array until the next clear
+    if ( array == NULL || ! arena.extend( array, size * sizeof( T ) ) )
+    {
+      T* grown = static_cast<T*>( arena.allocate( size * sizeof( T ) ) );
+      if ( grown == NULL ) return false;
+
+      for ( uint8_t i = 0; i < count; ++i ) new ( grown + i ) T( array[i] );
+      array = grown;
+    }
+
+    capacity = size;
+  }
+
+  new ( array + count ) T( value );
+  ++count;
+  return true;
+}
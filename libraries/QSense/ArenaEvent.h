@@ -0,0 +1,144 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef QSENSE_ARENAEVENT_H
+#define QSENSE_ARENAEVENT_H
+
+#if defined( ARDUINO )
+#include "Arena.h"
+#include "Event.h"
+#else
+#include <Arena.h>
+#include <Event.h>
+#endif
+
+namespace qsense
+{
+  /**
+   * @brief An event whose readings, tags and key-tags are allocated from
+   * an {@link Arena}, for an event that is built, published and rebuilt
+   * over and over again.
+   *
+   * Each list is held in an array that doubles in size when full, in place
+   * while it is the most recent allocation in the arena.  {@link #clear}
+   * rewinds the arena, which releases everything at once without touching
+   * the heap.  The arena should not be used for anything else while it
+   * holds an event.
+   *
+   * Readings with string values are not accepted, since the string would
+   * be on the heap.  Tags and keys of key-tags are copied into the arena.
+   * Anything that is not accepted, or does not fit in the arena, is dropped
+   * and reported by {@link #isTruncated}.
+   */
+  class ArenaEvent : public EventBase
+  {
+  public:
+    /// Create an event in the specified arena.  Uses default location
+    /// set through {@link Event#init}.
+    explicit ArenaEvent( Arena& arena );
+
+    /// Create an event in the specified arena with the specified location.
+    ArenaEvent( Arena& arena, const Location& location );
+
+    /// Add the specified reading to this event.  Ignored if it holds a
+    /// string, its key could not be interned or the arena is full.
+    ArenaEvent& add( const Reading& reading );
+
+    /// Add the specified tag to this event.  Ignored if the arena is full.
+    ArenaEvent& add( const char* tag ) { return addTag( tag, strlen( tag ) ); }
+
+    /// Add the specified tag to this event.  Ignored if the arena is full.
+    ArenaEvent& add( const QString& tag ) { return addTag( tag.data(), tag.size() ); }
+
+    /// Add the specified key-tag to this event.  Ignored if the arena is full.
+    ArenaEvent& add( const char* key, const char* tag )
+    {
+      return addKeyTag( key, strlen( key ), tag, strlen( tag ) );
+    }
+
+    /// Add the specified key-tag to this event.  Ignored if the arena is full.
+    ArenaEvent& add( const QString& key, const QString& tag )
+    {
+      return addKeyTag( key.data(), key.size(), tag.data(), tag.size() );
+    }
+
+    /// Operator for adding a reading to the event
+    ArenaEvent& operator += ( const Reading& reading ) { return add( reading ); }
+
+    /// Operator for adding a tag to the event.
+    ArenaEvent& operator += ( const char* tag ) { return add( tag ); }
+
+    /// Operator for adding a tag to the event.
+    ArenaEvent& operator += ( const QString& tag ) { return add( tag ); }
+
+    /// Remove all readings, tags and key-tags, and rewind the arena.
+    void clear();
+
+    std::size_t numberOfReadings() const { return readingCount; }
+
+    const Reading& getReading( std::size_t index ) const { return readings[index]; }
+
+    std::size_t numberOfTags() const { return tagCount; }
+
+    const char* getTag( std::size_t index ) const { return tags[index]; }
+
+    std::size_t numberOfKeyTags() const { return keyTagCount; }
+
+    const char* getKeyTags( std::size_t index, std::size_t& count ) const
+    {
+      count = keyTags[index].count;
+      return keyTags[index].key;
+    }
+
+    const char* getKeyTag( std::size_t index, std::size_t position ) const
+    {
+      return keyTags[index].tags[position];
+    }
+
+  private:
+    struct KeyTags
+    {
+      const char* key;
+      const char** tags;
+      uint8_t count;
+      uint8_t capacity;
+    };
+
+    ArenaEvent( const ArenaEvent& );
+    ArenaEvent& operator = ( const ArenaEvent& );
+
+    ArenaEvent& addTag( const char* tag, std::size_t length );
+    ArenaEvent& addKeyTag( const char* key, std::size_t keyLength,
+      const char* tag, std::size_t tagLength );
+    const char* copy( const char* text, std::size_t length );
+
+    template <typename T>
+    bool append( T*& array, uint8_t& count, uint8_t& capacity, const T& value );
+
+  private:
+    Arena& arena;
+    Reading* readings;
+    const char** tags;
+    KeyTags* keyTags;
+    uint8_t readingCount;
+    uint8_t readingCapacity;
+    uint8_t tagCount;
+    uint8_t tagCapacity;
+    uint8_t keyTagCount;
+    uint8_t keyTagCapacity;
+  };
+
+} // namespace qsense
+
+#endif // QSENSE_ARENAEVENT_H
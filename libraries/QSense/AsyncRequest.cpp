@@ -0,0 +1,230 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "AsyncRequest.h"
+
+#if defined( ARDUINO )
+#include "../StandardCplusplus/cstdlib"
+#else
+#include <cstdlib>
+#include <iostream>
+#include <net/DateTime.h>
+using qsense::net::millis;
+#endif
+
+using qsense::QString;
+using qsense::net::AsyncRequest;
+using qsense::net::HttpRequest;
+
+
+AsyncRequest::AsyncRequest( Connection& conn, uint32_t t ) :
+  ResponseParser::Handler(), connection( conn ), client(), request( NULL ),
+  method(), response(), parser(), started( 0 ), timeout( t ), sent( 0 ),
+  responseCode( 0 ), state( Idle ), headSent( false ),
+  received( false ), retried( false )
+{
+  parser.setHandler( this );
+}
+
+
+AsyncRequest::~AsyncRequest()
+{
+  if ( isActive() ) connection.close();
+  delete request;
+}
+
+
+bool AsyncRequest::begin( const QString& m, HttpRequest* req )
+{
+  if ( isActive() )
+  {
+    delete req;
+    return false;
+  }
+
+  reset();
+  request = req;
+  method = m;
+  started = millis();
+  state = Connecting;
+
+  client = connection.beginAcquire();
+  if ( client.isNull() ) fail();
+
+  return true;
+}
+
+
+AsyncRequest::State AsyncRequest::poll()
+{
+  if ( ! isActive() ) return state;
+
+  if ( uint32_t( millis() - started ) >= timeout )
+  {
+#if DEBUG
+    std::cout << F( "Request to " ) << request->getUri() << F( " timed out" ) << std::endl;
+#endif
+    retried = true;
+    fail();
+    return state;
+  }
+
+  switch ( state )
+  {
+    case Connecting:
+      connect();
+      break;
+    case Sending:
+      send();
+      break;
+    case AwaitingStatus:
+    case ReadingHeaders:
+    case ReadingBody:
+      receive();
+      break;
+    default:
+      break;
+  }
+
+  return state;
+}
+
+
+void AsyncRequest::reset()
+{
+  if ( isActive() ) connection.close();
+
+  delete request;
+  request = NULL;
+  client = HttpClient::Ptr();
+  response.clear();
+  parser.reset();
+  sent = 0;
+  responseCode = 0;
+  state = Idle;
+  headSent = received = retried = false;
+}
+
+
+void AsyncRequest::connect()
+{
+  if ( client->isConnecting() ) return;
+
+  if ( client->connected() ) state = Sending;
+  else fail();
+}
+
+
+void AsyncRequest::send()
+{
+  if ( ! client->connected() )
+  {
+    fail();
+    return;
+  }
+
+  if ( ! headSent )
+  {
+    client->writeHead( method, *request );
+    headSent = true;
+    return;
+  }
+
+  const QString& body = request->getBody();
+  if ( sent < body.size() )
+  {
+    std::size_t length = body.size() - sent;
+    if ( length > chunkSize ) length = chunkSize;
+
+    const std::size_t written = client->write( body.c_str() + sent, length );
+    if ( written == 0 )
+    {
+      fail();
+      return;
+    }
+
+    sent += written;
+  }
+
+  if ( sent >= body.size() ) state = AwaitingStatus;
+}
+
+
+void AsyncRequest::receive()
+{
+  char data[chunkSize];
+  const int count = client->read( data, chunkSize );
+  if ( count <= 0 )
+  {
+    if ( client->connected() ) return;
+
+    // Without framing the body is terminated by the server closing the
+    // connection.
+    parser.finish();
+    if ( parser.isComplete() ) complete( false );
+    else fail();
+    return;
+  }
+
+  received = true;
+  std::size_t used = 0;
+  while ( used < std::size_t( count ) && ! parser.isComplete() && ! parser.hasError() )
+  {
+    used += parser.parse( data + used, count - used );
+  }
+
+  responseCode = parser.getStatus();
+
+  if ( parser.isComplete() ) complete( parser.isKeepAlive() );
+  else if ( parser.hasError() ) fail();
+  else if ( parser.headersComplete() ) state = ReadingBody;
+  else if ( parser.getState() == ResponseParser::Headers ) state = ReadingHeaders;
+}
+
+
+void AsyncRequest::body( const char* data, std::size_t length )
+{
+  if ( response.size() + length > maxResponse ) length = maxResponse - response.size();
+  response.append( data, length );
+}
+
+
+void AsyncRequest::complete( bool reusable )
+{
+  connection.release( reusable );
+  client = HttpClient::Ptr();
+  state = Complete;
+}
+
+
+void AsyncRequest::fail()
+{
+  connection.close();
+
+  // Server closed the idle connection after we checked it, retry once
+  if ( state != Connecting && ! received && ! retried && connection.reused() )
+  {
+    retried = true;
+    headSent = false;
+    sent = 0;
+    parser.reset();
+    state = Connecting;
+
+    client = connection.beginAcquire();
+    if ( ! client.isNull() ) return;
+  }
+
+  client = HttpClient::Ptr();
+  state = Failed;
+}
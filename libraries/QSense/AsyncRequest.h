@@ -0,0 +1,165 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef QSENSE_NET_ASYNCREQUEST_H
+#define QSENSE_NET_ASYNCREQUEST_H
+
+#if defined( ARDUINO )
+#include "QSense.h"
+#include "Connection.h"
+#include "HttpRequest.h"
+#include "ResponseParser.h"
+#else
+#include <QSense.h>
+#include <net/Connection.h>
+#include <net/HttpRequest.h>
+#include <net/ResponseParser.h>
+#endif
+
+namespace qsense
+{
+  namespace net
+  {
+    /**
+     * @brief A HTTP request that is driven to completion by repeated calls
+     * to {@link #poll} instead of blocking the caller.
+     *
+     * Each call to {@link #poll} performs one step of the exchange, so that
+     * the application loop can keep servicing sensors while the request is
+     * in flight.  The request line and headers are written in one step,
+     * each following step writes at most \c chunkSize bytes of the body, and
+     * each read takes at most \c chunkSize bytes of the response.  Writes
+     * are collected in the client's send buffer (\c QSENSE_SEND_BUFFER_SIZE
+     * bytes), which is handed to the network in a single write when it
+     * fills or when the response is first read.  That write may block,
+     * though never past the client's request timeout.
+     *
+     * The request is sent over a {@link Connection}, and the connection is
+     * released (or closed) once the response has been read.
+     *
+     * The response is consumed with a {@link ResponseParser}, and only the
+     * first \c maxResponse bytes of the response body are retained.
+     */
+    class AsyncRequest : private ResponseParser::Handler
+    {
+    public:
+      /// The states through which a request progresses.
+      enum State
+      {
+        /// No request has been started.
+        Idle = 0,
+        /// Waiting for the connection to the server to be established.
+        Connecting,
+        /// Writing the request line, headers and body.
+        Sending,
+        /// Waiting for the response status line.
+        AwaitingStatus,
+        /// Reading the response headers.
+        ReadingHeaders,
+        /// Reading the response body.
+        ReadingBody,
+        /// The response was read.  Check {@link #getResponseCode}.
+        Complete,
+        /// The request could not be sent or the response could not be read.
+        Failed
+      };
+
+      /// Maximum number of body bytes written, or response bytes read, in
+      /// a single poll.
+      static const std::size_t chunkSize = 64;
+
+      /// Maximum number of response body bytes retained.
+      static const std::size_t maxResponse = 128;
+
+      /**
+       * @brief Create a new request that will be sent over the specified
+       * connection.
+       * @param connection The connection to use.  Must outlive the request.
+       * @param timeout Number of milliseconds after which the request is
+       *   abandoned if it has not completed.
+       */
+      AsyncRequest( Connection& connection, uint32_t timeout = 30000 );
+
+      /// Destructor.  Abandons any request in flight.
+      ~AsyncRequest();
+
+      /**
+       * @brief Start sending the specified request.  Nothing is written
+       * until the first {@link #poll}.
+       * @param method The HTTP method to use.
+       * @param request The request to send.  Ownership is transferred,
+       *   the request is retained until the next {@link #begin} or
+       *   {@link #reset} so that it may be inspected after completion.
+       * @return Returns \c false if a request is already in flight, in
+       *   which case \c request is deleted.
+       */
+      bool begin( const qsense::QString& method, HttpRequest* request );
+
+      /**
+       * @brief Perform the next step of the exchange.
+       * @return The state after the step.
+       */
+      State poll();
+
+      /// Return the current state of the request.
+      State getState() const { return state; }
+
+      /// Return \c true if the request has been started and not yet
+      /// completed or failed.
+      bool isActive() const { return state != Idle && state != Complete && state != Failed; }
+
+      /// Return the request that was started, or \c NULL when idle.
+      const HttpRequest* getRequest() const { return request; }
+
+      /// Return the HTTP response code, or \c 0 if no response was received.
+      uint16_t getResponseCode() const { return responseCode; }
+
+      /// Return the (possibly truncated) response body.
+      const qsense::QString& getResponse() const { return response; }
+
+      /// Abandon any request in flight and return to the \c Idle state.
+      void reset();
+
+    private:
+      AsyncRequest( const AsyncRequest& );
+      AsyncRequest& operator = ( const AsyncRequest& );
+
+      void connect();
+      void send();
+      void receive();
+      void body( const char* data, std::size_t length );
+      void complete( bool reusable );
+      void fail();
+
+    private:
+      Connection& connection;
+      HttpClient::Ptr client;
+      HttpRequest* request;
+      qsense::QString method;
+      qsense::QString response;
+      ResponseParser parser;
+      uint32_t started;
+      uint32_t timeout;
+      std::size_t sent;
+      uint16_t responseCode;
+      State state;
+      bool headSent;
+      bool received;
+      bool retried;
+    };
+
+  } // namespace net
+} // namespace qsense
+
+#endif // QSENSE_NET_ASYNCREQUEST_H
@@ -0,0 +1,220 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "CborEncoder.h"
+
+#if defined( ARDUINO )
+#include "../StandardCplusplus/cstring"
+#else
+#include <cstring>
+#endif
+
+namespace qsense
+{
+  namespace cbor
+  {
+    /// CBOR major types
+    enum Major
+    {
+      Unsigned = 0, Negative = 1, Bytes = 2, Text = 3, Array = 4, Map = 5, Tag = 6, Simple = 7
+    };
+
+    /// Tag for binary UUIDs
+    static const uint8_t uuidTag = 37;
+
+    /// Initial byte of a single precision float
+    static const uint8_t singleFloat = 0xFA;
+
+    /// Simple values for booleans
+    static const uint8_t falseValue = 0xF4;
+    static const uint8_t trueValue = 0xF5;
+
+    void bigEndian( std::streambuf& out, uint64_t value, uint8_t bytes )
+    {
+      while ( bytes-- > 0 ) out.sputc( static_cast<char>( value >> ( 8 * bytes ) ) );
+    }
+
+    void head( std::streambuf& out, Major major, uint64_t value )
+    {
+      const uint8_t type = uint8_t( major ) << 5;
+
+      if ( value < 24 ) out.sputc( static_cast<char>( type | value ) );
+      else if ( value <= 0xFF )
+      {
+        out.sputc( static_cast<char>( type | 24 ) );
+        bigEndian( out, value, 1 );
+      }
+      else if ( value <= 0xFFFF )
+      {
+        out.sputc( static_cast<char>( type | 25 ) );
+        bigEndian( out, value, 2 );
+      }
+      else if ( value <= 0xFFFFFFFFUL )
+      {
+        out.sputc( static_cast<char>( type | 26 ) );
+        bigEndian( out, value, 4 );
+      }
+      else
+      {
+        out.sputc( static_cast<char>( type | 27 ) );
+        bigEndian( out, value, 8 );
+      }
+    }
+
+    void text( std::streambuf& out, const char* data, std::size_t length )
+    {
+      head( out, Text, length );
+      out.sputn( data, length );
+    }
+
+    void text( std::streambuf& out, const qsense::QString& value )
+    {
+      text( out, value.data(), value.size() );
+    }
+
+    void text( std::streambuf& out, const char* value )
+    {
+      text( out, value, strlen( value ) );
+    }
+
+    void number( std::streambuf& out, float value )
+    {
+      uint32_t bits;
+      memcpy( &bits, &value, sizeof( bits ) );
+      out.sputc( static_cast<char>( singleFloat ) );
+      bigEndian( out, bits, 4 );
+    }
+
+    void timestamp( std::streambuf& out, int64_t epoch )
+    {
+      head( out, Unsigned, ( epoch < 0 ) ? 0 : uint64_t( epoch ) );
+    }
+
+    void uuid( std::streambuf& out, const qsense::UUID& id )
+    {
+      char bytes[16];
+      id.copyTo( bytes );
+
+      head( out, Tag, uuidTag );
+      head( out, Bytes, sizeof( bytes ) );
+      out.sputn( bytes, sizeof( bytes ) );
+    }
+
+    /// Encode the reading value in its native type
+    void value( std::streambuf& out, const qsense::Reading& reading )
+    {
+      using qsense::Reading;
+
+      switch ( reading.getType() )
+      {
+        case Reading::Float:
+          number( out, reading.getFloat() );
+          break;
+
+        case Reading::Integer:
+        {
+          const int32_t i = reading.getInteger();
+          if ( i >= 0 ) head( out, Unsigned, uint32_t( i ) );
+          else head( out, Negative, uint32_t( -( i + 1 ) ) );
+          break;
+        }
+
+        case Reading::Boolean:
+          out.sputc( static_cast<char>( reading.getBoolean() ? trueValue : falseValue ) );
+          break;
+
+        default:
+          text( out, reading.getText() );
+      }
+    }
+  }
+}
+
+using qsense::CborEncoder;
+using qsense::Event;
+
+
+void CborEncoder::encode( qsense::Sink& sink, const EventBase& event,
+    const qsense::UUID& id, int64_t ts ) const
+{
+  using namespace qsense::cbor;
+
+  qsense::SinkBuffer out( sink );
+
+  std::size_t fields = 6;
+  if ( event.numberOfTags() > 0 ) ++fields;
+  if ( event.numberOfKeyTags() > 0 ) ++fields;
+  head( out, Map, fields );
+
+  head( out, Unsigned, EventId );
+  uuid( out, id );
+  head( out, Unsigned, EventDeviceId );
+  uuid( out, Event::getDeviceId() );
+  head( out, Unsigned, EventTimestamp );
+  timestamp( out, ts );
+  head( out, Unsigned, EventStream );
+  text( out, Event::getStream() );
+
+  head( out, Unsigned, EventLocation );
+  head( out, Array, 2 );
+  number( out, event.getLocation().getLatitude() );
+  number( out, event.getLocation().getLongitude() );
+
+  head( out, Unsigned, EventReadings );
+  head( out, Array, event.numberOfReadings() );
+  for ( std::size_t i = 0; i < event.numberOfReadings(); ++i )
+  {
+    const qsense::Reading& reading = event.getReading( i );
+
+    // Readings taken at the time of the event do not repeat it
+    const bool withTimestamp = reading.getTimestamp() != ts;
+
+    head( out, Map, withTimestamp ? 3 : 2 );
+    head( out, Unsigned, ReadingKey );
+    text( out, reading.getKey() );
+    if ( withTimestamp )
+    {
+      head( out, Unsigned, ReadingTimestamp );
+      timestamp( out, reading.getTimestamp() );
+    }
+    head( out, Unsigned, ReadingValue );
+    value( out, reading );
+  }
+
+  if ( event.numberOfTags() > 0 )
+  {
+    head( out, Unsigned, EventTags );
+    head( out, Array, event.numberOfTags() );
+    for ( std::size_t i = 0; i < event.numberOfTags(); ++i )
+    {
+      text( out, event.getTag( i ) );
+    }
+  }
+
+  if ( event.numberOfKeyTags() > 0 )
+  {
+    head( out, Unsigned, EventKeyTags );
+    head( out, Map, event.numberOfKeyTags() );
+    for ( std::size_t i = 0; i < event.numberOfKeyTags(); ++i )
+    {
+      std::size_t count = 0;
+
+      text( out, event.getKeyTags( i, count ) );
+      head( out, Array, count );
+      for ( std::size_t j = 0; j < count; ++j ) text( out, event.getKeyTag( i, j ) );
+    }
+  }
+
+  out.pubsync();
+}
@@ -0,0 +1,68 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef QSENSE_CBORENCODER_H
+#define QSENSE_CBORENCODER_H
+
+#if defined( ARDUINO )
+#include "Encoder.h"
+#else
+#include <Encoder.h>
+#endif
+
+namespace qsense
+{
+  /**
+   * @brief Encodes events in the compact binary CBOR format (RFC 7049).
+   *
+   * Field names are replaced with the small integer keys below so that
+   * they cost a single byte each.  UUIDs are encoded as 16 byte strings
+   * (tagged \c 37), timestamps as integer milli seconds since UNIX epoch,
+   * reading values in their native type (single precision float, integer,
+   * boolean or text) and the location as a two element array.  Key-tags
+   * are encoded as a map from key to array of tags.  The timestamp of a
+   * reading is left out when it is the same as that of the event.
+   *
+   * A typical event with a few readings is less than half the size of
+   * its JSON representation.  Events are not batched with this encoder.
+   * The \c extras/ingest_server.py stand-in server decodes this format.
+   */
+  class CborEncoder : public Encoder
+  {
+  public:
+    /// Integer keys used in the event map.
+    enum EventField
+    {
+      EventId = 0, EventDeviceId = 1, EventTimestamp = 2, EventStream = 3,
+      EventLocation = 4, EventReadings = 5, EventTags = 6, EventKeyTags = 7
+    };
+
+    /// Integer keys used in each reading map.
+    enum ReadingField { ReadingKey = 0, ReadingTimestamp = 1, ReadingValue = 2 };
+
+    const char* contentType() const { return "application/cbor"; }
+
+    void encode( Sink& sink, const EventBase& event, const UUID& id, int64_t timestamp ) const;
+
+    /// Return a shared instance to use.
+    static const CborEncoder& singleton()
+    {
+      static CborEncoder encoder;
+      return encoder;
+    }
+  };
+
+} // namespace qsense
+
+#endif // QSENSE_CBORENCODER_H
@@ -0,0 +1,105 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "Connection.h"
+
+#if defined( ARDUINO )
+#include "../StandardCplusplus/iostream"
+#else
+#include <iostream>
+#endif
+
+using qsense::QString;
+using qsense::net::Connection;
+using qsense::net::HttpClient;
+
+
+Connection::Connection( const QString& srvr, uint16_t prt ) :
+  server( srvr ), port( prt ), client(), reuses( 0 ), reconnects( 0 ),
+  opened( false ), lastReused( false ) {}
+
+
+HttpClient::Ptr Connection::acquire()
+{
+  return acquire( true );
+}
+
+
+HttpClient::Ptr Connection::beginAcquire()
+{
+  return acquire( false );
+}
+
+
+HttpClient::Ptr Connection::reconnect()
+{
+  close();
+  return open( true );
+}
+
+
+void Connection::release( bool reusable )
+{
+  if ( ! reusable ) close();
+}
+
+
+void Connection::close()
+{
+  if ( client.isNull() ) return;
+
+  client->stop();
+  client = HttpClient::Ptr();
+}
+
+
+HttpClient::Ptr Connection::acquire( bool wait )
+{
+  if ( ! client.isNull() && client->connected() )
+  {
+    ++reuses;
+    lastReused = true;
+    return client;
+  }
+
+  return open( wait );
+}
+
+
+HttpClient::Ptr Connection::open( bool wait )
+{
+  close();
+  lastReused = false;
+
+  HttpClient::Ptr ptr = HttpClient::create();
+  if ( ptr.isNull() ) return ptr;
+
+  ptr->setKeepAlive( true );
+  const int16_t result = wait ? ptr->connect( server, port ) : ptr->beginConnect( server, port );
+  if ( ! result )
+  {
+    std::cout << F( "Connection to " ) << server << F( " failed" ) << std::endl;
+    return HttpClient::Ptr();
+  }
+
+#if DEBUG
+  std::cout << F( "Connected to " ) << server << std::endl;
+#endif
+
+  if ( opened ) ++reconnects;
+  opened = true;
+
+  client = ptr;
+  return client;
+}
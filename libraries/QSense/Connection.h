@@ -0,0 +1,127 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef QSENSE_NET_CONNECTION_H
+#define QSENSE_NET_CONNECTION_H
+
+#if defined( ARDUINO )
+#include "QSense.h"
+#include "QHttpClient.h"
+#else
+#include <QSense.h>
+#include <net/QHttpClient.h>
+#endif
+
+namespace qsense
+{
+  namespace net
+  {
+    /**
+     * @brief Manages a single persistent (HTTP keep-alive) connection to
+     * a server.
+     *
+     * The connection is opened lazily on the first call to {@link #acquire}
+     * and kept open across requests.  If the server closes the connection
+     * while it is idle, the next {@link #acquire} transparently opens a
+     * new one.  Counters for the number of times the open connection was
+     * reused and the number of times it had to be re-established are
+     * maintained for diagnostic purposes.
+     */
+    class Connection
+    {
+    public:
+      /**
+       * @brief Create a new manager for connections to the specified server.
+       * No connection is made until {@link #acquire} is invoked.
+       * @param server The host name of the server to connect to.
+       * @param port The port on which to connect (default 80).
+       */
+      Connection( const qsense::QString& server, uint16_t port = 80 );
+
+      /// Destructor.  Closes the connection if open.
+      ~Connection() { close(); }
+
+      /**
+       * @brief Return a client connected to the server.  Reuses the
+       * currently open connection if the server has not closed it,
+       * otherwise opens a new connection.
+       * @return The connected client, or a \c null pointer if a
+       *   connection could not be established.
+       */
+      HttpClient::Ptr acquire();
+
+      /**
+       * @brief Non-blocking variant of {@link #acquire}.  If a new
+       * connection has to be opened, the returned client may still be
+       * connecting.  Poll {@link HttpClient#isConnecting} until it returns
+       * \c false and then check {@link HttpClient#connected}.
+       * @return The client, or a \c null pointer if a connection could
+       *   not be started.
+       */
+      HttpClient::Ptr beginAcquire();
+
+      /**
+       * @brief Drop the current connection and open a new one.  Use when
+       * a request on a reused connection failed because the server closed
+       * it after {@link #acquire} checked its state.
+       * @return The connected client, or a \c null pointer on failure.
+       */
+      HttpClient::Ptr reconnect();
+
+      /**
+       * @brief Indicate that the current request/response exchange is
+       * complete.
+       * @param reusable Pass \c false if the response was not fully
+       *   consumed or the server asked to close the connection.  The
+       *   connection will be closed in that case.
+       */
+      void release( bool reusable );
+
+      /// Close the current connection if open.
+      void close();
+
+      /// Return the host name of the server.
+      const qsense::QString& getServer() const { return server; }
+
+      /// Return \c true if the last {@link #acquire} returned an already open connection.
+      bool reused() const { return lastReused; }
+
+      /// Return the number of requests that were sent over an already open connection.
+      uint32_t reuseCount() const { return reuses; }
+
+      /// Return the number of times a connection had to be re-established
+      /// after the previous one was closed.
+      uint32_t reconnectCount() const { return reconnects; }
+
+    private:
+      Connection( const Connection& );
+      Connection& operator = ( const Connection& );
+
+      HttpClient::Ptr acquire( bool wait );
+      HttpClient::Ptr open( bool wait );
+
+    private:
+      const qsense::QString server;
+      const uint16_t port;
+      HttpClient::Ptr client;
+      uint32_t reuses;
+      uint32_t reconnects;
+      bool opened;
+      bool lastReused;
+    };
+
+  } // namespace net
+} // namespace qsense
+
+#endif // QSENSE_NET_CONNECTION_H
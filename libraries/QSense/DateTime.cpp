@@ -18,14 +18,35 @@ limitations under the License.
 #if defined( ARDUINO )
 #include "../StandardCplusplus/cstdlib"
 #include "../StandardCplusplus/iostream"
-#include "../StandardCplusplus/sstream"
 #else
 #include <cstdlib>
 #include <iostream>
-#include <sstream>
 #include <Poco/Timestamp.h>
 #endif
 
+namespace qsense
+{
+  namespace net
+  {
+    namespace data
+    {
+      static const char statusServer[] PROGMEM = "api.sidecar.io";
+      static const char statusUri[] PROGMEM = "/rest/status/";
+
+      /// Write the value as a zero padded decimal, ending at \c end
+      void pad( char* end, int value, uint8_t width )
+      {
+        while ( width-- > 0 )
+        {
+          *--end = static_cast<char>( '0' + value % 10 );
+          value /= 10;
+        }
+      }
+    }
+  }
+}
+
+using qsense::FlashString;
 using qsense::QString;
 using qsense::net::DateTime;
 
@@ -103,21 +124,18 @@ const qsense::QString DateTime::serverTime()
   using qsense::net::HttpClient;
   using qsense::net::HttpRequest;
 
-  static QString server( "api.sidecar.io" );
-  static QString uri( "/rest/status/" );
-  static QString userAgentKey( "User-Agent" );
-  static QString userAgentValue( "QSense" );
+  const FlashString server( data::statusServer );
 
   HttpClient::Ptr client = HttpClient::create();
 
-  if ( client->connect( server ) )
+  if ( client->connect( server.toString() ) )
   {
 #if DEBUG
     std::cout << F( "Connected to " ) << server << std::endl;
 #endif
 
-    HttpRequest request( uri );
-    request.setHeader( userAgentKey, userAgentValue );
+    HttpRequest request( FlashString( data::statusUri ).toString() );
+    request.setHeader( HttpRequest::UserAgent, "QSense" );
 
     uint16_t responseCode = client->get( request );
 
@@ -201,6 +219,13 @@ int64_t DateTime::epochMilliSeconds( const QString& date ) const
 
 
 QString DateTime::isoTime( int64_t epoch ) const
+{
+  char buffer[isoLength];
+  return QString( buffer, isoTime( epoch, buffer ) );
+}
+
+
+std::size_t DateTime::isoTime( int64_t epoch, char* buffer ) const
 {
   const int millis = epoch % int64_t( 1000 );
   epoch /= int64_t( 1000 );
@@ -249,29 +274,23 @@ QString DateTime::isoTime( int64_t epoch ) const
     else break;
   }
 
-  int day = epoch + 1;
-  std::stringstream ss;
-  ss << year << '-';
-
-  if ( month < 10 ) ss << 0;
-  ss << month << '-';
-
-  if ( day < 10 ) ss << 0;
-  ss << day << 'T';
-
-  if ( hour < 10 ) ss << 0;
-  ss << hour << ':';
-
-  if ( minute < 10 ) ss << 0;
-  ss << minute << ':';
-
-  if ( second < 10 ) ss << 0;
-  ss << second << '.';
-
-  if ( millis < 10 ) ss << "00";
-  else if ( millis < 100 ) ss << "0";
-  ss << millis << 'Z';
-
-  return ss.str();
+  const int day = epoch + 1;
+
+  // Fixed width fields, no stream required
+  data::pad( buffer + 4, year, 4 );
+  buffer[4] = '-';
+  data::pad( buffer + 7, month, 2 );
+  buffer[7] = '-';
+  data::pad( buffer + 10, day, 2 );
+  buffer[10] = 'T';
+  data::pad( buffer + 13, hour, 2 );
+  buffer[13] = ':';
+  data::pad( buffer + 16, minute, 2 );
+  buffer[16] = ':';
+  data::pad( buffer + 19, second, 2 );
+  buffer[19] = '.';
+  data::pad( buffer + 23, millis, 3 );
+  buffer[23] = 'Z';
+
+  return isoLength;
 }
-
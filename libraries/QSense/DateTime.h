@@ -46,6 +46,27 @@ namespace qsense
       /// Return the milli seconds since UNIX epoch.
       int64_t currentTimeMillis();
 
+      /// Return the milli seconds since UNIX epoch for the specified
+      /// ISO 8601 date/time.
+      int64_t epochMilliSeconds( const qsense::QString& iso8601 ) const;
+
+      /// Return the ISO 8601 representation of the specified milli seconds
+      /// since UNIX epoch.
+      qsense::QString isoTime( int64_t epoch ) const;
+
+      /**
+       * @brief Write the ISO 8601 representation of the specified milli
+       * seconds since UNIX epoch without allocating.
+       * @param epoch The milli seconds since UNIX epoch.
+       * @param buffer The buffer of at least \c isoLength bytes to write
+       *   to.  The text is not null terminated.
+       * @return The number of characters written, always \c isoLength.
+       */
+      std::size_t isoTime( int64_t epoch, char* buffer ) const;
+
+      /// Length of the ISO 8601 representation, \c 2015-05-04T01:51:59.000Z
+      static const std::size_t isoLength = 24;
+
       /// Return a singleton instance to use.  This is the preferred way
       /// of using this class.
       static DateTime& singleton()
@@ -58,8 +79,6 @@ namespace qsense
       void init();
       const qsense::QString serverTime();
       bool isLeapYear( int16_t year ) const;
-      int64_t epochMilliSeconds( const qsense::QString& iso8601 ) const;
-      qsense::QString isoTime( int64_t epoch ) const;
 
     private:
       static const int64_t milliSecondsPerHour;
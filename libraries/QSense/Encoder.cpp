@@ -0,0 +1,32 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "Encoder.h"
+
+#if defined( ARDUINO )
+#include "JsonWriter.h"
+#else
+#include <JsonWriter.h>
+#endif
+
+using qsense::JsonEncoder;
+
+
+void JsonEncoder::encode( qsense::Sink& sink, const qsense::EventBase& event,
+    const qsense::UUID& id, int64_t timestamp ) const
+{
+  qsense::JsonWriter writer( sink );
+  event.serialise( writer, id.toString(), timestamp );
+  writer.flush();
+}
@@ -0,0 +1,86 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef QSENSE_ENCODER_H
+#define QSENSE_ENCODER_H
+
+#if defined( ARDUINO )
+#include "QSense.h"
+#include "Event.h"
+#include "Sink.h"
+#include "UUID.h"
+#else
+#include <QSense.h>
+#include <Event.h>
+#include <Sink.h>
+#include <UUID.h>
+#endif
+
+namespace qsense
+{
+  /**
+   * @brief Interface for the wire formats in which events are published.
+   *
+   * Encoders are stateless, and must produce identical output when
+   * invoked repeatedly with the same arguments, since events are encoded
+   * once to compute the hash and again to write them to the connection.
+   * Select the encoder to use with
+   * {@link qsense::net::SidecarClient#setEncoder}.
+   */
+  class Encoder
+  {
+  public:
+    /// Destructor for sub-classes
+    virtual ~Encoder() {}
+
+    /// Return the value for the \c Content-Type header of encoded events.
+    virtual const char* contentType() const = 0;
+
+    /// Return \c true if encoded events may be combined in an {@link EventBatch}.
+    virtual bool supportsBatch() const { return false; }
+
+    /**
+     * @brief Encode the specified event.
+     * @param sink The destination for the encoded event.
+     * @param event The event to encode.
+     * @param id The unique identifier for the event.
+     * @param timestamp The milli seconds since UNIX epoch at which the
+     *   event was created.
+     */
+    virtual void encode( Sink& sink, const EventBase& event,
+      const UUID& id, int64_t timestamp ) const = 0;
+  };
+
+
+  /// The JSON representation documented for the Sidecar Event API.
+  class JsonEncoder : public Encoder
+  {
+  public:
+    const char* contentType() const { return "application/json"; }
+
+    bool supportsBatch() const { return true; }
+
+    void encode( Sink& sink, const EventBase& event, const UUID& id, int64_t timestamp ) const;
+
+    /// Return a shared instance to use.
+    static const JsonEncoder& singleton()
+    {
+      static JsonEncoder encoder;
+      return encoder;
+    }
+  };
+
+} // namespace qsense
+
+#endif // QSENSE_ENCODER_H
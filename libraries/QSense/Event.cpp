@@ -16,10 +16,10 @@ limitations under the License.
 
 #if defined( ARDUINO )
 #include "DateTime.h"
-#include "../StandardCplusplus/sstream"
+#include "JsonWriter.h"
 #else
 #include <net/DateTime.h>
-#include <sstream>
+#include <JsonWriter.h>
 #endif
 
 namespace qsense
@@ -33,20 +33,26 @@ namespace qsense
 }
 
 using qsense::Event;
+using qsense::EventBase;
 using qsense::Location;
 using qsense::Reading;
 using qsense::QString;
 
 
-Event::Event() : readings(), tags(), location( qsense::data::location ) {}
+EventBase::EventBase() : location( qsense::data::location ), truncated( false ) {}
 
 
-Event::Event( const Location& loc ) : readings(), tags(), location( loc ) {}
+Event::Event() : EventBase(), readings(), tags(), keyTags() {}
+
+
+Event::Event( const Location& loc ) : EventBase( loc ), readings(), tags(), keyTags() {}
 
 
 Event& Event::add( const Reading& reading )
 {
-  readings.push_back( reading );
+  if ( reading.getKeySymbol().isValid() ) readings.push_back( reading );
+  else truncated = true;
+
   return *this;
 }
 
@@ -60,16 +66,32 @@ Event& Event::add( const QString& tag )
 
 Event& Event::add( const QString& key, const QString& tag )
 {
-  keyTags[key].push_back( tag );
+  // Few keys are expected, a linear scan is cheaper than a map
+  for ( KeyTags::iterator iter = keyTags.begin(); iter != keyTags.end(); ++iter )
+  {
+    if ( iter->first == key )
+    {
+      iter->second.push_back( tag );
+      return *this;
+    }
+  }
+
+  keyTags.push_back( std::make_pair( key, Tags( 1, tag ) ) );
   return *this;
 }
 
 
-const QString Event::toString() const
+const QString EventBase::toString() const
 {
-  std::stringstream ss;
-  ss << *this;
-  return ss.str();
+  using qsense::UUID;
+  using qsense::net::DateTime;
+
+  QString str;
+  qsense::StringSink sink( str );
+  qsense::JsonWriter writer( sink );
+  serialise( writer, UUID::create().toString(), DateTime::singleton().currentTimeMillis() );
+  writer.flush();
+  return str;
 }
 
 
@@ -82,71 +104,103 @@ void Event::init( const qsense::UUID& deviceId, const QString& stream,
 }
 
 
-std::ostream& qsense::operator << ( std::ostream& os, const Event& event )
+const qsense::UUID& Event::getDeviceId()
+{
+  return qsense::data::deviceId;
+}
+
+
+const QString& Event::getStream()
+{
+  return qsense::data::stream;
+}
+
+
+const Location& Event::getDefaultLocation()
+{
+  return qsense::data::location;
+}
+
+
+void EventBase::serialise( std::ostream& os, const QString& id,
+    int64_t timestamp ) const
+{
+  qsense::StreamSink sink( os );
+  qsense::JsonWriter writer( sink );
+  serialise( writer, id, timestamp );
+}
+
+
+void EventBase::serialise( qsense::JsonWriter& writer, const QString& id,
+    int64_t timestamp ) const
 {
-  using qsense::UUID;
   using qsense::net::DateTime;
 
-  os <<
-    "{\"id\": \"" << UUID::create().toString() <<
-    "\", \"deviceId\": \"" << qsense::data::deviceId <<
-    "\", \"ts\": \"" << DateTime::singleton().currentTime() <<
-    "\", \"stream\": \"" << qsense::data::stream <<
-    "\", \"location\": " << event.getLocation() <<
-    ", \"readings\": [";
+  char iso[DateTime::isoLength];
+  DateTime::singleton().isoTime( timestamp, iso );
 
-  bool first = true;
-  for ( Event::ReadingsIterator iter = event.beginReadings(); iter != event.endReadings(); ++iter )
+  // Field names are written from flash on Arduino
+  writer.raw( F( "{\"id\": " ) ).string( id ).
+    raw( F( ", \"deviceId\": " ) ).string( qsense::data::deviceId.toString() ).
+    raw( F( ", \"ts\": \"" ) ).raw( iso, sizeof( iso ) ).
+    raw( F( "\", \"stream\": " ) ).string( qsense::data::stream ).
+    raw( F( ", \"location\": " ) ) << location;
+  writer.raw( F( ", \"readings\": [" ) );
+
+  for ( std::size_t i = 0; i < numberOfReadings(); ++i )
   {
-    if ( ! first ) os << ", ";
-    os << *iter;
-    first = false;
+    if ( i > 0 ) writer.raw( F( ", " ) );
+    writer << getReading( i );
   }
 
-  os << "]";
+  writer.raw( ']' );
 
-  if ( event.numberOfTags() > 0 )
+  if ( numberOfTags() > 0 )
   {
-    os << ", ";
-    first = true;
-    os << "\"tags\": [";
+    writer.raw( F( ", \"tags\": [" ) );
 
-    for ( Event::TagsIterator iter = event.beginTags(); iter != event.endTags(); ++iter )
+    for ( std::size_t i = 0; i < numberOfTags(); ++i )
     {
-      if ( ! first ) os << ", ";
-      os << "\"" << *iter << "\"";
-      first = false;
+      if ( i > 0 ) writer.raw( F( ", " ) );
+      writer.string( getTag( i ) );
     }
 
-    os << "]";
+    writer.raw( ']' );
   }
 
-  if ( event.numberOfKeyTags() > 0 )
+  if ( numberOfKeyTags() > 0 )
   {
-    os << ", \"keyTags\": [";
-    first = true;
+    writer.raw( F( ", \"keyTags\": [" ) );
 
-    for ( Event::KeyTagsIterator iter = event.beginKeyTags(); iter != event.endKeyTags(); ++iter )
+    for ( std::size_t i = 0; i < numberOfKeyTags(); ++i )
     {
-      if ( ! first ) os << ", ";
-      os << "{\"key\": \"" << iter->first << "\",";
-      os << "\"tags\": [";
+      std::size_t count = 0;
+      const char* key = getKeyTags( i, count );
+
+      if ( i > 0 ) writer.raw( F( ", " ) );
+      writer.raw( F( "{\"key\": " ) ).string( key ).raw( F( ",\"tags\": [" ) );
 
-      bool tf = true;
-      for ( Event::TagsIterator ti = iter->second.begin(); ti != iter->second.end(); ++ti )
+      for ( std::size_t j = 0; j < count; ++j )
       {
-        if ( ! tf ) os << ", ";
-        os << "\"" << *ti << "\"";
-        tf = false;
+        if ( j > 0 ) writer.raw( F( ", " ) );
+        writer.string( getKeyTag( i, j ) );
       }
 
-      os << "]}";
-      first = false;
+      writer.raw( F( "]}" ) );
     }
 
-    os << "]";
+    writer.raw( ']' );
   }
 
-  os << "}";
+  writer.raw( '}' );
+}
+
+
+std::ostream& qsense::operator << ( std::ostream& os, const EventBase& event )
+{
+  using qsense::UUID;
+  using qsense::net::DateTime;
+
+  event.serialise( os, UUID::create().toString(), DateTime::singleton().currentTimeMillis() );
   return os;
 }
@@ -19,26 +19,117 @@ limitations under the License.
 #include "QSense.h"
 #include "Location.h"
 #include "Reading.h"
+#include "Symbol.h"
 #include "UUID.h"
 #include "../StandardCplusplus/vector"
-#include "../StandardCplusplus/map"
+#include "../StandardCplusplus/utility.h"
 #else
 #include <QSense.h>
 #include <Location.h>
 #include <Reading.h>
+#include <Symbol.h>
 #include <UUID.h>
 #include <vector>
-#include <map>
+#include <utility>
 #endif
 
 namespace qsense
 {
+  /**
+   * @brief The readings, tags and key-tags of an event, independent of
+   * how they are held.  Events are serialised and encoded through this
+   * interface, so that an {@link Event} and a {@link StaticEvent} are
+   * published in the same way.
+   */
+  class EventBase
+  {
+  public:
+    /// Destructor for sub-classes
+    virtual ~EventBase() {}
+
+    /// Return the number of readings in this event.
+    virtual std::size_t numberOfReadings() const = 0;
+
+    /// Return the reading at the specified index.
+    virtual const qsense::Reading& getReading( std::size_t index ) const = 0;
+
+    /// Return the number of tags associated with this event.
+    virtual std::size_t numberOfTags() const = 0;
+
+    /// Return the tag at the specified index.  The text is held by the
+    /// event and is valid until the event is changed.
+    virtual const char* getTag( std::size_t index ) const = 0;
+
+    /// Return the number of keys with tags associated with this event.
+    virtual std::size_t numberOfKeyTags() const = 0;
+
+    /**
+     * @brief Return the key of the key-tags at the specified index.
+     * @param index The index of the key, less than {@link #numberOfKeyTags}.
+     * @param count Set to the number of tags associated with the key.
+     * @return The key, held by the event as with {@link #getTag}.
+     */
+    virtual const char* getKeyTags( std::size_t index, std::size_t& count ) const = 0;
+
+    /**
+     * @brief Return a tag associated with the key at the specified index.
+     * @param index The index of the key, less than {@link #numberOfKeyTags}.
+     * @param position The position of the tag, less than the count set by
+     *   {@link #getKeyTags}.
+     * @return The tag, held by the event as with {@link #getTag}.
+     */
+    virtual const char* getKeyTag( std::size_t index, std::size_t position ) const = 0;
+
+    /// Return \c true if anything added to this event was dropped, such
+    /// as a reading whose key could not be interned.
+    bool isTruncated() const { return truncated; }
+
+    /// Return the location used by this event
+    const qsense::Location& getLocation() const { return location; }
+
+    /// Serialise the event to JSON
+    const qsense::QString toString() const;
+
+    /**
+     * @brief Serialise the event to JSON using the specified identifier
+     * and timestamp.  Serialising twice with the same values produces
+     * identical output, which allows the length and hash of an event to
+     * be computed in one pass and the event written out in a second pass
+     * without holding the JSON in memory.
+     * @param writer The writer to write to.  Keys, tags and string values
+     *   are escaped.
+     * @param id The unique identifier for the event.
+     * @param timestamp The milli seconds since UNIX epoch at which the
+     *   event was created.  Formatted as ISO 8601 only when written.
+     */
+    void serialise( JsonWriter& writer, const qsense::QString& id,
+      int64_t timestamp ) const;
+
+    /// Serialise the event to JSON to the output stream, as with
+    /// {@link #serialise(JsonWriter&,const QString&,int64_t)}.
+    void serialise( std::ostream& os, const qsense::QString& id,
+      int64_t timestamp ) const;
+
+  protected:
+    /// Uses default location set through {@link Event#init}
+    EventBase();
+
+    /// Use the specified location
+    EventBase( const Location& loc ) : location( loc ), truncated( false ) {}
+
+  protected:
+    Location location;
+    bool truncated;
+  };
+
+
   /**
    * @brief A simple class that encapsulates an event sent to Sidecar.
    * Events are holders for readings.  Events can be serialised to JSON
-   * using the {@link #toString} method.
+   * using the {@link #toString} method.  Reading keys are held as interned
+   * {@link Symbol}s, tags are copied into the event.
    */
-  class Event
+  class Event : public EventBase
   {
   public:
     /// The vector of readings encapsulated in this event.
@@ -47,8 +138,9 @@ namespace qsense
     /// The vector of tags associated with this event.
     typedef std::vector<QString> Tags;
 
-    /// The map of key tags associated with this event.
-    typedef std::map<QString,Tags> KeyTags;
+    /// The key tags associated with this event, in the order in which
+    /// the keys were added.
+    typedef std::vector<std::pair<QString,Tags> > KeyTags;
 
     /// Iterator for the readings encapsulated in this event.
     typedef Readings::const_iterator ReadingsIterator;
@@ -68,7 +160,8 @@ namespace qsense
     /// Destructor.  No actions required
     ~Event() {}
 
-    /// Add the specified reading to this event.
+    /// Add the specified reading to this event.  Dropped and reported by
+    /// {@link #isTruncated} if its key could not be interned.
     Event& add( const Reading& reading );
 
     /// Add the specified tag to this event.
@@ -95,15 +188,27 @@ namespace qsense
       return *this;
     }
 
-    /// Return the number of readings in this event.
     std::size_t numberOfReadings() const { return readings.size(); }
 
-    /// Return the number of tags associated with this event.
+    const qsense::Reading& getReading( std::size_t index ) const { return readings[index]; }
+
     std::size_t numberOfTags() const { return tags.size(); }
 
-    /// Return the number of key-tags associated with this event.
+    const char* getTag( std::size_t index ) const { return tags[index].c_str(); }
+
     std::size_t numberOfKeyTags() const { return keyTags.size(); }
 
+    const char* getKeyTags( std::size_t index, std::size_t& count ) const
+    {
+      count = keyTags[index].second.size();
+      return keyTags[index].first.c_str();
+    }
+
+    const char* getKeyTag( std::size_t index, std::size_t position ) const
+    {
+      return keyTags[index].second[position].c_str();
+    }
+
     /// Return a constant iterator to the beginning of the readings vector
     ReadingsIterator beginReadings() const { return readings.begin(); }
 
@@ -119,7 +224,7 @@ namespace qsense
     /// Return a constant iterator to the beginning of the key-tags vector
     KeyTagsIterator beginKeyTags() const { return keyTags.begin(); }
 
-    /// The end of the key-tags map to check in loops.
+    /// The end of the key-tags vector to check in loops.
     KeyTagsIterator endKeyTags() const { return keyTags.end(); }
 
     /**
@@ -135,12 +240,6 @@ namespace qsense
       return readings[index];
     }
 
-    /// Return the location used by this event
-    const qsense::Location& getLocation() const { return location; }
-
-    /// Serialise the event to JSON
-    const qsense::QString toString() const;
-
     /**
      * @brief Initialise the Event API
      * @param deviceId The deviceId to use.  No way at present to retrieve using API
@@ -150,15 +249,23 @@ namespace qsense
     static void init( const qsense::UUID& deviceId,
       const qsense::QString& stream, const qsense::Location& location );
 
+    /// Return the device identifier specified through {@link #init}.
+    static const qsense::UUID& getDeviceId();
+
+    /// Return the stream identifier specified through {@link #init}.
+    static const qsense::QString& getStream();
+
+    /// Return the default location specified through {@link #init}.
+    static const qsense::Location& getDefaultLocation();
+
   private:
     Readings readings;
     Tags tags;
     KeyTags keyTags;
-    Location location;
   };
 
   /// Serialise the specified event as JSON to the output stream
-  std::ostream& operator << ( std::ostream& os, const Event& event );
+  std::ostream& operator << ( std::ostream& os, const EventBase& event );
 
 } // namespace qsense
 
@@ -0,0 +1,153 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "EventBatch.h"
+
+#if defined( ARDUINO )
+#include "../StandardCplusplus/cstdlib"
+#else
+#include <cstdlib>
+#include <net/DateTime.h>
+using qsense::net::millis;
+#endif
+
+namespace qsense
+{
+  namespace data
+  {
+    static const char batchPrefix[] PROGMEM = "{\"events\": [";
+    static const char batchSuffix[] PROGMEM = "]}";
+  }
+}
+
+using qsense::EventBatch;
+using qsense::FlashString;
+using qsense::QString;
+
+
+EventBatch::EventBatch( uint8_t events, uint16_t size, uint32_t age ) :
+  body(), firstAdded( 0 ), maxBytes( size ), maxAge( age ),
+  callback( NULL ), context( NULL ), maxEvents( events ), count( 0 )
+{
+  clear();
+}
+
+
+bool EventBatch::add( const EventBase& event )
+{
+  if ( count >= maxEvents && count > 0 ) return false;
+  return add( event.toString() );
+}
+
+
+bool EventBatch::add( const QString& event )
+{
+  if ( count >= maxEvents && count > 0 ) return false;
+
+  QString json( event );
+  if ( count > 0 )
+  {
+    if ( body.size() + json.size() + 2 > maxBytes ) return false;
+    json.insert( 0, ", " );
+  }
+  else firstAdded = millis();
+
+  // Insert before the closing suffix
+  body.insert( body.size() - suffix().size(), json );
+  ++count;
+  return true;
+}
+
+
+bool EventBatch::isDue() const
+{
+  if ( count == 0 ) return false;
+  if ( count >= maxEvents ) return true;
+  if ( body.size() >= maxBytes ) return true;
+  return ( maxAge > 0 ) && ( uint32_t( millis() - firstAdded ) >= maxAge );
+}
+
+
+void EventBatch::clear()
+{
+  body.clear();
+  qsense::StringSink sink( body );
+  prefix().write( sink );
+  suffix().write( sink );
+
+  count = 0;
+  firstAdded = 0;
+}
+
+
+FlashString EventBatch::prefix()
+{
+  return FlashString( qsense::data::batchPrefix );
+}
+
+
+FlashString EventBatch::suffix()
+{
+  return FlashString( qsense::data::batchSuffix );
+}
+
+
+void EventBatch::setCallback( Callback cb, void* ctx )
+{
+  callback = cb;
+  context = ctx;
+}
+
+
+void EventBatch::notify( uint16_t responseCode, const QString& response ) const
+{
+  if ( callback == NULL ) return;
+
+  for ( std::size_t i = 0; i < count; ++i )
+  {
+    bool accepted = false;
+    if ( responseCode == 202 ) accepted = true;
+    else if ( responseCode == 207 ) accepted = ! isRejected( i, response );
+
+    callback( i, accepted, context );
+  }
+}
+
+
+bool EventBatch::isRejected( std::size_t index, const QString& response ) const
+{
+  std::size_t start = response.find( "\"rejected\"" );
+  if ( start == QString::npos ) return false;
+
+  start = response.find( '[', start );
+  const std::size_t end = response.find( ']', start );
+  if ( start == QString::npos || end == QString::npos ) return false;
+
+  const char* ptr = response.c_str() + start + 1;
+  const char* last = response.c_str() + end;
+
+  while ( ptr < last )
+  {
+    char* next = NULL;
+    const long value = std::strtol( ptr, &next, 10 );
+    if ( next == ptr ) ++ptr;
+    else
+    {
+      if ( value >= 0 && std::size_t( value ) == index ) return true;
+      ptr = next;
+    }
+  }
+
+  return false;
+}
@@ -0,0 +1,145 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef QSENSE_EVENTBATCH_H
+#define QSENSE_EVENTBATCH_H
+
+#if defined( ARDUINO )
+#include "QSense.h"
+#include "Event.h"
+#include "FlashString.h"
+#else
+#include <QSense.h>
+#include <Event.h>
+#include <FlashString.h>
+#endif
+
+namespace qsense
+{
+  /**
+   * @brief Accumulates multiple events that are published in a single
+   * request.
+   *
+   * Events are serialised as they are added, and the batch is sent with
+   * one \c Content-MD5 hash and one signature using
+   * {@link qsense::net::SidecarClient#publish(EventBatch&)}.  The Sidecar
+   * Event API is not documented to accept batches, so they are only sent
+   * to a receiver set with
+   * {@link qsense::net::SidecarClient#setBatchEndpoint} that does.  A batch
+   * should be flushed (published) when {@link #isDue} returns \c true,
+   * which happens when any of the configured count, size or age limits
+   * is reached.
+   *
+   * The result for each event in the batch is reported through the
+   * callback registered with {@link #setCallback}, using the index at
+   * which the event was added.
+   */
+  class EventBatch
+  {
+  public:
+    /**
+     * @brief Callback invoked with the result of publishing each event.
+     * @param index The zero-based index of the event in the batch.
+     * @param accepted \c true if Sidecar accepted the event.
+     * @param context The context pointer registered with the callback.
+     */
+    typedef void (*Callback)( std::size_t index, bool accepted, void* context );
+
+    /**
+     * @brief Create a new batch with the specified flush policies.
+     * @param maxEvents Flush once this many events have been added.
+     * @param maxBytes Flush once the serialised batch reaches this size.
+     *   An event that would take the batch over this size is not added.
+     * @param maxAge Flush once the oldest event in the batch has waited
+     *   this many milliseconds.  Specify \c 0 to disable.
+     */
+    EventBatch( uint8_t maxEvents = 10, uint16_t maxBytes = 1024,
+      uint32_t maxAge = 60000 );
+
+    /// Destructor.  No actions required.
+    ~EventBatch() {}
+
+    /**
+     * @brief Serialise and add the specified event to the batch.
+     * @return Returns \c false if the batch is full (by count or size),
+     *   in which case the batch should be published and the event added
+     *   again.  An event is always accepted into an empty batch.
+     */
+    bool add( const EventBase& event );
+
+    /**
+     * @brief Add an already serialised event to the batch.
+     * @see #add(const EventBase&)
+     */
+    bool add( const qsense::QString& event );
+
+    /// Return \c true if any of the count, size or age limits has been reached.
+    bool isDue() const;
+
+    /// Return the number of events in the batch.
+    std::size_t size() const { return count; }
+
+    /// Return \c true if there are no events in the batch.
+    bool empty() const { return count == 0; }
+
+    /// Return the size in bytes of the serialised batch.
+    std::size_t bytes() const { return body.size(); }
+
+    /// Return the serialised batch to use as the request body.
+    const qsense::QString& getBody() const { return body; }
+
+    /// Remove all events from the batch.
+    void clear();
+
+    /// Return the text that opens a serialised batch, ahead of the events.
+    static qsense::FlashString prefix();
+
+    /// Return the text that closes a serialised batch.
+    static qsense::FlashString suffix();
+
+    /// Register the callback to invoke with the result for each event.
+    void setCallback( Callback callback, void* context = NULL );
+
+    /**
+     * @brief Map the response from the receiver to results for each event
+     * and invoke the registered callback.
+     *
+     * The receiver is assumed to respond as follows, which is not part
+     * of the Sidecar Event API.  A \c 202 response indicates that all
+     * events were accepted.  A \c 207 response lists the (zero-based)
+     * indices of rejected events in a \c rejected array in the response
+     * body.  Any other response indicates that all events were rejected.
+     *
+     * @param responseCode The HTTP response code returned by the receiver.
+     * @param response The response body returned by the receiver.
+     */
+    void notify( uint16_t responseCode, const qsense::QString& response ) const;
+
+  private:
+    bool isRejected( std::size_t index, const qsense::QString& response ) const;
+
+  private:
+    qsense::QString body;
+    uint32_t firstAdded;
+    uint16_t maxBytes;
+    uint32_t maxAge;
+    Callback callback;
+    void* context;
+    uint8_t maxEvents;
+    uint8_t count;
+  };
+
+} // namespace qsense
+
+#endif // QSENSE_EVENTBATCH_H
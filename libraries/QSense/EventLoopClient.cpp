@@ -0,0 +1,518 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "EventLoopClient.h"
+
+#if ! defined( ARDUINO ) && defined( __linux__ )
+
+#include <net/DateTime.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using qsense::QString;
+using qsense::net::EventLoopClient;
+using qsense::net::HttpRequest;
+using qsense::net::ResponseParser;
+using qsense::net::millis;
+
+
+/// A request waiting to be sent or in flight.
+struct EventLoopClient::Request
+{
+  Request( const QString& m, HttpRequest* r, Callback cb, void* ctx ) :
+    method( m ), request( r ), callback( cb ), context( ctx ),
+    retried( false ) {}
+
+  ~Request() { delete request; }
+
+  QString method;
+  HttpRequest* request;
+  Callback callback;
+  void* context;
+  bool retried;
+};
+
+
+/// A non-blocking connection to a server.
+struct EventLoopClient::Socket : ResponseParser::Handler
+{
+  enum State { Connecting, Sending, Receiving, Idle };
+
+  Socket( Server& s, int f ) : server( s ), fd( f ), state( Connecting ),
+    request( NULL ), out(), sent( 0 ), parser( this ), response(),
+    deadline( 0 ), reused( false ), received( false ) {}
+
+  void body( const char* data, std::size_t length ) { response.append( data, length ); }
+
+  Server& server;
+  int fd;
+  State state;
+  Request* request;
+  std::string out;
+  std::size_t sent;
+  ResponseParser parser;
+  QString response;
+  uint32_t deadline;
+  bool reused;
+  bool received;
+};
+
+
+/// The queue of requests and the connections for a server.
+struct EventLoopClient::Server
+{
+  QString name;
+  uint16_t port;
+  sockaddr_storage address;
+  socklen_t length;
+  std::deque<Request*> queue;
+  std::vector<Socket*> sockets;
+};
+
+
+namespace qsense
+{
+  namespace net
+  {
+    namespace data
+    {
+      /// Render the request line, headers and body of a request.
+      std::string render( const QString& method, const HttpRequest& request,
+        const QString& host )
+      {
+        std::stringstream ss;
+        ss << method << ' ' << request.getUri();
+        if ( request.getParamters().size() > 0 ) ss << '?' << request.getParamters();
+        ss << " HTTP/1.1\r\nHost: " << host << "\r\n";
+
+        for ( HttpRequest::HeaderIterator iter = request.beginHeaders();
+            iter != request.endHeaders(); ++iter )
+        {
+          if ( iter->getId() == HttpRequest::CustomHeader ) ss << iter->getName();
+          else ss << HttpRequest::getHeaderName( iter->getId() );
+          ss << ": ";
+          ss.write( iter->getValue(), iter->getLength() );
+          ss << "\r\n";
+        }
+
+        const QString& body = request.getBody();
+        if ( body.size() > 0 && request.getHeader( HttpRequest::ContentLength ) == NULL )
+        {
+          ss << "Content-Length: " << body.size() << "\r\n";
+        }
+
+        ss << "\r\n" << body;
+        return ss.str();
+      }
+    }
+  }
+}
+
+
+EventLoopClient::EventLoopClient( std::size_t max, uint32_t t ) :
+  servers(), maxConnections( max ), count( 0 ), timeout( t ),
+  epoll( epoll_create1( EPOLL_CLOEXEC ) ) {}
+
+
+EventLoopClient::~EventLoopClient()
+{
+  for ( std::size_t i = 0; i < servers.size(); ++i )
+  {
+    Server* server = servers[i];
+    for ( std::size_t j = 0; j < server->sockets.size(); ++j )
+    {
+      ::close( server->sockets[j]->fd );
+      delete server->sockets[j]->request;
+      delete server->sockets[j];
+    }
+
+    for ( std::size_t j = 0; j < server->queue.size(); ++j ) delete server->queue[j];
+    delete server;
+  }
+
+  if ( epoll >= 0 ) ::close( epoll );
+}
+
+
+bool EventLoopClient::submit( const QString& name, uint16_t port,
+    const QString& method, HttpRequest* request, Callback callback, void* context )
+{
+  Server* server = find( name, port );
+  if ( server == NULL )
+  {
+    delete request;
+    return false;
+  }
+
+  server->queue.push_back( new Request( method, request, callback, context ) );
+  ++count;
+  dispatch( *server );
+  return true;
+}
+
+
+std::size_t EventLoopClient::poll( int wait )
+{
+  epoll_event events[64];
+  const int ready = epoll_wait( epoll, events, 64, wait );
+
+  for ( int i = 0; i < ready; ++i )
+  {
+    handle( *static_cast<Socket*>( events[i].data.ptr ), events[i].events );
+  }
+
+  // Abandon requests that missed their deadline
+  std::vector<Socket*> expired;
+  const uint32_t now = millis();
+  for ( std::size_t i = 0; i < servers.size(); ++i )
+  {
+    for ( std::size_t j = 0; j < servers[i]->sockets.size(); ++j )
+    {
+      Socket* socket = servers[i]->sockets[j];
+      if ( socket->state != Socket::Idle && int32_t( now - socket->deadline ) >= 0 )
+      {
+        expired.push_back( socket );
+      }
+    }
+  }
+
+  for ( std::size_t i = 0; i < expired.size(); ++i )
+  {
+#if DEBUG
+    std::cout << F( "Request to " ) << expired[i]->server.name << F( " timed out" ) << std::endl;
+#endif
+    expired[i]->request->retried = true;
+    fail( *expired[i] );
+  }
+
+  return count;
+}
+
+
+std::size_t EventLoopClient::connections() const
+{
+  std::size_t total = 0;
+  for ( std::size_t i = 0; i < servers.size(); ++i ) total += servers[i]->sockets.size();
+  return total;
+}
+
+
+EventLoopClient::Server* EventLoopClient::find( const QString& name, uint16_t port )
+{
+  for ( std::size_t i = 0; i < servers.size(); ++i )
+  {
+    if ( servers[i]->name == name && servers[i]->port == port ) return servers[i];
+  }
+
+  // Resolved once, requests are always made to the same few servers
+  std::stringstream ss;
+  ss << port;
+
+  addrinfo hints;
+  memset( &hints, 0, sizeof( hints ) );
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+
+  addrinfo* result = NULL;
+  if ( getaddrinfo( name.c_str(), ss.str().c_str(), &hints, &result ) != 0 ) return NULL;
+
+  Server* server = new Server;
+  server->name = name;
+  server->port = port;
+  memcpy( &server->address, result->ai_addr, result->ai_addrlen );
+  server->length = result->ai_addrlen;
+  freeaddrinfo( result );
+
+  servers.push_back( server );
+  return server;
+}
+
+
+void EventLoopClient::dispatch( Server& server )
+{
+  while ( ! server.queue.empty() )
+  {
+    Socket* socket = NULL;
+    for ( std::size_t i = 0; i < server.sockets.size() && socket == NULL; ++i )
+    {
+      if ( server.sockets[i]->state == Socket::Idle ) socket = server.sockets[i];
+    }
+
+    if ( socket == NULL )
+    {
+      if ( server.sockets.size() >= maxConnections ) return;
+
+      if ( ! open( server ) )
+      {
+        // Nothing in flight to retry the queued requests after
+        if ( ! server.sockets.empty() ) return;
+
+        Request* request = server.queue.front();
+        server.queue.pop_front();
+        --count;
+        if ( request->callback != NULL ) request->callback( 0, QString(), request->context );
+        delete request;
+        continue;
+      }
+
+      socket = server.sockets.back();
+    }
+
+    Request* request = server.queue.front();
+    server.queue.pop_front();
+    start( *socket, request );
+  }
+}
+
+
+bool EventLoopClient::open( Server& server )
+{
+  const int fd = ::socket( server.address.ss_family,
+      SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 );
+  if ( fd < 0 ) return false;
+
+  int flag = 1;
+  setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof( flag ) );
+
+  if ( ::connect( fd, reinterpret_cast<sockaddr*>( &server.address ), server.length ) < 0 &&
+      errno != EINPROGRESS )
+  {
+    ::close( fd );
+    return false;
+  }
+
+  Socket* socket = new Socket( server, fd );
+  socket->deadline = millis() + timeout;
+
+  epoll_event event;
+  event.events = EPOLLOUT;
+  event.data.ptr = socket;
+  epoll_ctl( epoll, EPOLL_CTL_ADD, fd, &event );
+
+  server.sockets.push_back( socket );
+  return true;
+}
+
+
+void EventLoopClient::start( Socket& socket, Request* request )
+{
+  socket.request = request;
+  socket.out = data::render( request->method, *request->request, socket.server.name );
+  socket.sent = 0;
+  socket.parser.reset();
+  socket.response.clear();
+  socket.received = false;
+
+  // A new connection starts sending once it is established
+  if ( socket.state == Socket::Idle )
+  {
+    socket.reused = true;
+    socket.deadline = millis() + timeout;
+    socket.state = Socket::Sending;
+    watch( socket, EPOLLOUT );
+  }
+}
+
+
+void EventLoopClient::handle( Socket& socket, uint32_t events )
+{
+  switch ( socket.state )
+  {
+    case Socket::Connecting:
+    {
+      int error = 0;
+      socklen_t length = sizeof( error );
+      getsockopt( socket.fd, SOL_SOCKET, SO_ERROR, &error, &length );
+      if ( error != 0 || ( events & ( EPOLLERR | EPOLLHUP ) ) )
+      {
+        fail( socket );
+        return;
+      }
+
+      socket.state = Socket::Sending;
+      send( socket );
+      break;
+    }
+
+    case Socket::Sending:
+      send( socket );
+      break;
+
+    case Socket::Receiving:
+      receive( socket );
+      break;
+
+    case Socket::Idle:
+      // The server closed the idle connection
+      close( socket );
+      break;
+  }
+}
+
+
+void EventLoopClient::send( Socket& socket )
+{
+  while ( socket.sent < socket.out.size() )
+  {
+    const ssize_t sent = ::send( socket.fd, socket.out.data() + socket.sent,
+        socket.out.size() - socket.sent, MSG_NOSIGNAL );
+    if ( sent < 0 )
+    {
+      if ( errno == EINTR ) continue;
+      if ( errno != EAGAIN && errno != EWOULDBLOCK ) fail( socket );
+      return;
+    }
+
+    socket.sent += sent;
+  }
+
+  socket.state = Socket::Receiving;
+  watch( socket, EPOLLIN );
+}
+
+
+void EventLoopClient::receive( Socket& socket )
+{
+  char data[4096];
+
+  for ( ;; )
+  {
+    const ssize_t received = ::recv( socket.fd, data, sizeof( data ), 0 );
+    if ( received < 0 )
+    {
+      if ( errno == EINTR ) continue;
+      if ( errno != EAGAIN && errno != EWOULDBLOCK ) fail( socket );
+      return;
+    }
+
+    if ( received == 0 )
+    {
+      socket.parser.finish();
+      if ( socket.parser.isComplete() ) complete( socket );
+      else fail( socket );
+      return;
+    }
+
+    socket.received = true;
+    std::size_t used = 0;
+    while ( used < std::size_t( received ) &&
+        ! socket.parser.isComplete() && ! socket.parser.hasError() )
+    {
+      used += socket.parser.parse( data + used, received - used );
+    }
+
+    if ( socket.parser.hasError() )
+    {
+      fail( socket );
+      return;
+    }
+
+    if ( socket.parser.isComplete() )
+    {
+      complete( socket );
+      return;
+    }
+  }
+}
+
+
+void EventLoopClient::complete( Socket& socket )
+{
+  Server& server = socket.server;
+  Request* request = socket.request;
+  socket.request = NULL;
+
+  const uint16_t status = socket.parser.getStatus();
+  QString response;
+  response.swap( socket.response );
+
+  if ( socket.parser.isKeepAlive() )
+  {
+    socket.state = Socket::Idle;
+    watch( socket, EPOLLIN );
+  }
+  else close( socket );
+
+  --count;
+  if ( request->callback != NULL ) request->callback( status, response, request->context );
+  delete request;
+
+  dispatch( server );
+}
+
+
+void EventLoopClient::fail( Socket& socket )
+{
+  Server& server = socket.server;
+  Request* request = socket.request;
+  socket.request = NULL;
+
+  // Server closed the idle connection as it was reused, retry once
+  const bool retry = socket.reused && ! socket.received && ! request->retried;
+  close( socket );
+
+  if ( retry )
+  {
+    request->retried = true;
+    server.queue.push_front( request );
+  }
+  else
+  {
+    --count;
+    if ( request->callback != NULL ) request->callback( 0, QString(), request->context );
+    delete request;
+  }
+
+  dispatch( server );
+}
+
+
+void EventLoopClient::close( Socket& socket )
+{
+  epoll_ctl( epoll, EPOLL_CTL_DEL, socket.fd, NULL );
+  ::close( socket.fd );
+
+  std::vector<Socket*>& sockets = socket.server.sockets;
+  for ( std::size_t i = 0; i < sockets.size(); ++i )
+  {
+    if ( sockets[i] == &socket )
+    {
+      sockets.erase( sockets.begin() + i );
+      break;
+    }
+  }
+
+  delete &socket;
+}
+
+
+void EventLoopClient::watch( Socket& socket, uint32_t events )
+{
+  epoll_event event;
+  event.events = events;
+  event.data.ptr = &socket;
+  epoll_ctl( epoll, EPOLL_CTL_MOD, socket.fd, &event );
+}
+
+#endif // ! ARDUINO && __linux__
@@ -0,0 +1,142 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef QSENSE_NET_EVENTLOOPCLIENT_H
+#define QSENSE_NET_EVENTLOOPCLIENT_H
+
+#if ! defined( ARDUINO ) && defined( __linux__ )
+
+#include <QSense.h>
+#include <net/HttpRequest.h>
+#include <net/QHttpClient.h>
+#include <net/ResponseParser.h>
+
+#include <deque>
+#include <vector>
+
+namespace qsense
+{
+  namespace net
+  {
+    /**
+     * @brief A HTTP client for Linux gateways that keeps many requests in
+     * flight at once on a single thread.
+     *
+     * Requests are queued per server, and sent over a pool of non-blocking
+     * keep-alive connections of at most \c maxConnections per server.  All
+     * connections are multiplexed with \c epoll, and {@link #poll} performs
+     * whatever sends and receives are ready without blocking beyond the
+     * wait requested.  The outcome of each request is reported to its
+     * callback:
+     *
+     * \code
+     * EventLoopClient client( 8 );
+     * client.submit( "api.sidecar.io", 80, "POST", request, published, &device );
+     * while ( client.pending() > 0 ) client.poll( 100 );
+     * \endcode
+     *
+     * Only available in the host (non Arduino) build on Linux.
+     */
+    class EventLoopClient
+    {
+    public:
+      /**
+       * @brief Signature of the function invoked when a request completes.
+       * @param responseCode The HTTP response code, or \c 0 if no response
+       *   was received.
+       * @param response The response body.
+       * @param context The context given to {@link #submit}.
+       */
+      typedef void (*Callback)( uint16_t responseCode,
+        const qsense::QString& response, void* context );
+
+      /**
+       * @brief Create a new client.
+       * @param maxConnections The maximum number of connections opened to
+       *   each server.
+       * @param timeout Number of milliseconds within which a connection
+       *   must be established, and a request sent and its response read.
+       */
+      EventLoopClient( std::size_t maxConnections = 4,
+        uint32_t timeout = QSENSE_REQUEST_TIMEOUT );
+
+      /// Destructor.  Closes all connections.  Requests still pending are
+      /// abandoned without invoking their callbacks.
+      ~EventLoopClient();
+
+      /**
+       * @brief Queue a request.  Nothing is sent until {@link #poll}.
+       * @param server The host name of the server.
+       * @param port The port on the server.
+       * @param method The HTTP method to use.
+       * @param request The request to send.  Ownership is transferred.
+       * @param callback The function to invoke with the response.  May be
+       *   \c NULL.
+       * @param context Passed to the callback.
+       * @return Returns \c false if the server name could not be resolved,
+       *   in which case the request is deleted.
+       */
+      bool submit( const qsense::QString& server, uint16_t port,
+        const qsense::QString& method, HttpRequest* request,
+        Callback callback = NULL, void* context = NULL );
+
+      /**
+       * @brief Perform the sends and receives that are ready, and report
+       * the requests that completed.
+       * @param wait Maximum number of milliseconds to wait for a connection
+       *   to become ready.
+       * @return The number of requests queued or in flight.
+       */
+      std::size_t poll( int wait = 0 );
+
+      /// Return the number of requests queued or in flight.
+      std::size_t pending() const { return count; }
+
+      /// Return the number of connections currently open.
+      std::size_t connections() const;
+
+    private:
+      struct Request;
+      struct Socket;
+      struct Server;
+
+      EventLoopClient( const EventLoopClient& );
+      EventLoopClient& operator = ( const EventLoopClient& );
+
+      Server* find( const qsense::QString& name, uint16_t port );
+      void dispatch( Server& server );
+      bool open( Server& server );
+      void start( Socket& socket, Request* request );
+      void handle( Socket& socket, uint32_t events );
+      void send( Socket& socket );
+      void receive( Socket& socket );
+      void complete( Socket& socket );
+      void fail( Socket& socket );
+      void close( Socket& socket );
+      void watch( Socket& socket, uint32_t events );
+
+    private:
+      std::vector<Server*> servers;
+      std::size_t maxConnections;
+      std::size_t count;
+      uint32_t timeout;
+      int epoll;
+    };
+
+  } // namespace net
+} // namespace qsense
+
+#endif // ! ARDUINO && __linux__
+
+#endif // QSENSE_NET_EVENTLOOPCLIENT_H
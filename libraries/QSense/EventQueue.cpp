@@ -0,0 +1,216 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "EventQueue.h"
+
+using qsense::Byte;
+using qsense::EventQueue;
+using qsense::QString;
+
+
+EventQueue::EventQueue( DropPolicy p ) :
+  drops( 0 ), head( 0 ), used( 0 ), count( 0 ), inFlight( 0 ), policy( p ) {}
+
+
+bool EventQueue::push( const QString& event, uint8_t priority )
+{
+  const std::size_t size = event.size() + headerSize;
+  if ( size > capacity() || event.size() > 0xFFFF )
+  {
+    ++drops;
+    return false;
+  }
+
+  while ( used + size > capacity() )
+  {
+    switch ( policy )
+    {
+      case DropNewest:
+        ++drops;
+        return false;
+      case DropLowestPriority:
+        if ( ! dropLowerPriority( priority ) )
+        {
+          ++drops;
+          return false;
+        }
+        break;
+      default:
+        // The oldest event that is not being sent
+        if ( inFlight == count )
+        {
+          ++drops;
+          return false;
+        }
+        if ( inFlight == 0 ) pop();
+        else erase( offsetOf( inFlight ) );
+        ++drops;
+    }
+  }
+
+  std::size_t offset = used;
+  set( offset++, Byte( event.size() & 0xFF ) );
+  set( offset++, Byte( event.size() >> 8 ) );
+  set( offset++, priority );
+
+  for ( std::size_t i = 0; i < event.size(); ++i )
+  {
+    set( offset++, static_cast<Byte>( event[i] ) );
+  }
+
+  used += size;
+  ++count;
+  return true;
+}
+
+
+bool EventQueue::peek( std::size_t index, QString& event ) const
+{
+  if ( index >= count ) return false;
+
+  std::size_t offset = offsetOf( index );
+  const std::size_t size = sizeAt( offset );
+  offset += headerSize;
+
+  event.clear();
+  event.reserve( size );
+  for ( std::size_t i = 0; i < size; ++i ) event += static_cast<char>( at( offset + i ) );
+
+  return true;
+}
+
+
+bool EventQueue::peek( std::size_t index, qsense::Sink& sink ) const
+{
+  if ( index >= count ) return false;
+
+  const std::size_t offset = offsetOf( index );
+  const std::size_t size = sizeAt( offset );
+  const std::size_t start = ( head + offset + headerSize ) % capacity();
+
+  // An event that wraps around the end of the buffer is written in two parts
+  const std::size_t first = ( size < capacity() - start ) ? size : capacity() - start;
+  sink.write( reinterpret_cast<const char*>( buffer + start ), first );
+  if ( first < size ) sink.write( reinterpret_cast<const char*>( buffer ), size - first );
+
+  return true;
+}
+
+
+std::size_t EventQueue::length( std::size_t index ) const
+{
+  return ( index < count ) ? sizeAt( offsetOf( index ) ) : 0;
+}
+
+
+void EventQueue::pop( std::size_t number )
+{
+  for ( ; number > 0 && count > 0; --number )
+  {
+    const std::size_t size = headerSize + sizeAt( 0 );
+    head = ( head + size ) % capacity();
+    used -= size;
+    --count;
+    if ( inFlight > 0 ) --inFlight;
+  }
+
+  if ( count == 0 ) head = used = 0;
+}
+
+
+void EventQueue::pin( std::size_t number )
+{
+  inFlight = ( number < count ) ? number : count;
+}
+
+
+void EventQueue::release( bool remove )
+{
+  if ( remove ) pop( inFlight );
+  inFlight = 0;
+}
+
+
+void EventQueue::clear()
+{
+  head = used = count = inFlight = 0;
+}
+
+
+Byte EventQueue::at( std::size_t offset ) const
+{
+  return buffer[( head + offset ) % capacity()];
+}
+
+
+void EventQueue::set( std::size_t offset, Byte value )
+{
+  buffer[( head + offset ) % capacity()] = value;
+}
+
+
+std::size_t EventQueue::offsetOf( std::size_t index ) const
+{
+  std::size_t offset = 0;
+  for ( std::size_t i = 0; i < index; ++i ) offset += headerSize + sizeAt( offset );
+  return offset;
+}
+
+
+std::size_t EventQueue::sizeAt( std::size_t offset ) const
+{
+  return std::size_t( at( offset ) ) | ( std::size_t( at( offset + 1 ) ) << 8 );
+}
+
+
+bool EventQueue::dropLowerPriority( uint8_t priority )
+{
+  std::size_t lowest = 0;
+  uint8_t lowestPriority = 0xFF;
+  bool found = false;
+
+  // Events being sent are not candidates
+  std::size_t offset = offsetOf( inFlight );
+  for ( std::size_t i = inFlight; i < count; ++i )
+  {
+    const uint8_t p = at( offset + 2 );
+    if ( ! found || p < lowestPriority )
+    {
+      lowest = offset;
+      lowestPriority = p;
+      found = true;
+    }
+
+    offset += headerSize + sizeAt( offset );
+  }
+
+  if ( ! found || lowestPriority > priority ) return false;
+
+  erase( lowest );
+  ++drops;
+  return true;
+}
+
+
+void EventQueue::erase( std::size_t offset )
+{
+  const std::size_t size = headerSize + sizeAt( offset );
+
+  // Close the gap by moving the newer events towards the front
+  for ( std::size_t i = offset + size; i < used; ++i ) set( i - size, at( i ) );
+
+  used -= size;
+  --count;
+  if ( count == 0 ) head = used = 0;
+}
@@ -0,0 +1,174 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef QSENSE_EVENTQUEUE_H
+#define QSENSE_EVENTQUEUE_H
+
+#if defined( ARDUINO )
+#include "QSense.h"
+#include "Sink.h"
+#else
+#include <QSense.h>
+#include <Sink.h>
+#endif
+
+#ifndef QSENSE_EVENT_QUEUE_SIZE
+// Number of bytes reserved for events held while Sidecar is unreachable
+#if defined( ARDUINO )
+#define QSENSE_EVENT_QUEUE_SIZE 1024
+#else
+#define QSENSE_EVENT_QUEUE_SIZE 65536
+#endif
+#endif
+
+namespace qsense
+{
+  /**
+   * @brief A fixed capacity ring buffer of serialised events.
+   *
+   * Used to hold events that could not be published while Sidecar is
+   * unreachable, so that they can be published in order once the
+   * connection is restored.  All storage is reserved up front
+   * (\c QSENSE_EVENT_QUEUE_SIZE bytes), so the queue never allocates
+   * memory regardless of the length of an outage.  When an event does
+   * not fit, events are dropped as specified by the {@link DropPolicy}.
+   * Events being sent are {@link #pin pinned}, and are never dropped to
+   * make room.
+   *
+   * Each event is stored with a three byte header (length and priority).
+   * Queued events are written to the connection straight from the queue
+   * with {@link #peek(std::size_t,Sink&) const}, so draining the queue
+   * needs no memory beyond the queue itself either.
+   */
+  class EventQueue
+  {
+  public:
+    /// Policy used to make room when the queue is full.
+    enum DropPolicy
+    {
+      /// Drop the oldest events to make room for the new event.
+      DropOldest = 0,
+      /// Drop the new event.
+      DropNewest = 1,
+      /// Drop the events with the lowest priority (oldest first), or the
+      /// new event if its priority is lower than all queued events.
+      DropLowestPriority = 2
+    };
+
+    /// Create an empty queue that uses the specified drop policy.
+    EventQueue( DropPolicy policy = DropOldest );
+
+    /// Destructor.  No actions required.
+    ~EventQueue() {}
+
+    /**
+     * @brief Add the serialised event to the end of the queue.
+     * @param event The serialised event.
+     * @param priority The priority of the event.  Higher values are
+     *   retained longer with the \c DropLowestPriority policy.
+     * @return Returns \c false if the event was dropped.
+     */
+    bool push( const qsense::QString& event, uint8_t priority = 0 );
+
+    /**
+     * @brief Retrieve the serialised event at the specified position.
+     * @param index The position in the queue, with \c 0 being the oldest.
+     * @param event The string to copy the event into.
+     * @return Returns \c false if there is no event at the position.
+     */
+    bool peek( std::size_t index, qsense::QString& event ) const;
+
+    /**
+     * @brief Write the serialised event at the specified position to the
+     * sink, without copying it out of the queue.
+     * @param index The position in the queue, with \c 0 being the oldest.
+     * @param sink The sink to write the event to.
+     * @return Returns \c false if there is no event at the position.
+     */
+    bool peek( std::size_t index, qsense::Sink& sink ) const;
+
+    /// Return the number of bytes of the serialised event at the specified
+    /// position, or \c 0 if there is none.
+    std::size_t length( std::size_t index ) const;
+
+    /// Remove the specified number of events from the front of the queue.
+    void pop( std::size_t number = 1 );
+
+    /**
+     * @brief Mark the specified number of the oldest events as in flight,
+     * so that no drop policy removes them until they are released.
+     * @param number The number of events being sent.
+     */
+    void pin( std::size_t number );
+
+    /**
+     * @brief Release the events marked as in flight with {@link #pin}.
+     * @param remove \c true to remove them from the queue, as they were
+     *   delivered, \c false to keep them to send again.
+     */
+    void release( bool remove );
+
+    /// Return the number of events marked as in flight.
+    std::size_t pinned() const { return inFlight; }
+
+    /// Remove all events from the queue.
+    void clear();
+
+    /// Return the number of events in the queue.
+    std::size_t size() const { return count; }
+
+    /// Return \c true if there are no events in the queue.
+    bool empty() const { return count == 0; }
+
+    /// Return the number of bytes used (including per event overhead).
+    std::size_t bytes() const { return used; }
+
+    /// Return the total number of bytes available for storage.
+    static std::size_t capacity() { return QSENSE_EVENT_QUEUE_SIZE; }
+
+    /// Return the number of events dropped since the queue was created.
+    uint32_t dropped() const { return drops; }
+
+    /// Return the policy used to make room when the queue is full.
+    DropPolicy getDropPolicy() const { return policy; }
+
+    /// Set the policy used to make room when the queue is full.
+    void setDropPolicy( DropPolicy p ) { policy = p; }
+
+  private:
+    EventQueue( const EventQueue& );
+    EventQueue& operator = ( const EventQueue& );
+
+    qsense::Byte at( std::size_t offset ) const;
+    void set( std::size_t offset, qsense::Byte value );
+    std::size_t offsetOf( std::size_t index ) const;
+    std::size_t sizeAt( std::size_t offset ) const;
+    bool dropLowerPriority( uint8_t priority );
+    void erase( std::size_t offset );
+
+  private:
+    static const std::size_t headerSize = 3;
+
+    qsense::Byte buffer[QSENSE_EVENT_QUEUE_SIZE];
+    uint32_t drops;
+    std::size_t head;
+    std::size_t used;
+    std::size_t count;
+    std::size_t inFlight;
+    DropPolicy policy;
+  };
+
+} // namespace qsense
+
+#endif // QSENSE_EVENTQUEUE_H
@@ -0,0 +1,105 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "FlashString.h"
+
+#if defined( ARDUINO )
+#include <avr/pgmspace.h>
+#include "../StandardCplusplus/cctype"
+#else
+#include <cctype>
+#endif
+
+namespace qsense
+{
+  namespace data
+  {
+    /// Number of characters copied from flash at a time when streaming.
+    const std::size_t flashChunk = 16;
+  }
+}
+
+using qsense::QString;
+using qsense::FlashString;
+using qsense::StringSink;
+
+
+bool FlashString::contains( char c ) const
+{
+  for ( const char* p = ptr; ; ++p )
+  {
+    const char ch = static_cast<char>( pgm_read_byte( p ) );
+    if ( ch == c ) return true;
+    if ( ch == '\0' ) return false;
+  }
+}
+
+
+bool FlashString::equalsIgnoreCase( const QString& other ) const
+{
+  for ( std::size_t i = 0; i < other.size(); ++i )
+  {
+    const char c = at( i );
+    if ( c == '\0' || tolower( c ) != tolower( other[i] ) ) return false;
+  }
+
+  return at( other.size() ) == '\0';
+}
+
+
+std::size_t FlashString::copy( char* dest, std::size_t length, std::size_t position ) const
+{
+  std::size_t count = 0;
+  for ( const char* p = ptr + position; count < length; ++p, ++count )
+  {
+    const char c = static_cast<char>( pgm_read_byte( p ) );
+    if ( c == '\0' ) break;
+    dest[count] = c;
+  }
+
+  return count;
+}
+
+
+void FlashString::write( Sink& sink ) const
+{
+  char chunk[data::flashChunk];
+  std::size_t position = 0;
+
+  for ( std::size_t count = copy( chunk, sizeof( chunk ) ); count > 0;
+      count = copy( chunk, sizeof( chunk ), position ) )
+  {
+    sink.write( chunk, count );
+    position += count;
+  }
+}
+
+
+QString FlashString::toString() const
+{
+  QString str;
+  str.reserve( size() );
+
+  StringSink sink( str );
+  write( sink );
+  return str;
+}
+
+
+std::ostream& qsense::operator << ( std::ostream& os, const FlashString& str )
+{
+  qsense::StreamSink sink( os );
+  str.write( sink );
+  return os;
+}
@@ -0,0 +1,107 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef QSENSE_FLASHSTRING_H
+#define QSENSE_FLASHSTRING_H
+
+#if defined( ARDUINO )
+#include "QSense.h"
+#include "Sink.h"
+#include "../StandardCplusplus/ostream"
+#else
+#include <QSense.h>
+#include <Sink.h>
+#include <ostream>
+#endif
+
+namespace qsense
+{
+  /**
+   * @brief A constant string stored in flash (\c PROGMEM) on Arduino.
+   *
+   * Constant strings such as server names, URIs and header names are
+   * declared as \c PROGMEM arrays, and wrapped in a flash string where
+   * they are used.  The contents are streamed to their destination a
+   * few bytes at a time, and never copied to SRAM as a whole:
+   *
+   * \code
+   * static const char server[] PROGMEM = "api.sidecar.io";
+   * os << FlashString( server );
+   * \endcode
+   *
+   * In the host build \c PROGMEM is empty, and the string is an ordinary
+   * constant.
+   */
+  class FlashString
+  {
+  public:
+    /// Create a new instance for the specified \c PROGMEM string.
+    explicit FlashString( const char* progmem ) : ptr( progmem ) {}
+
+    /// Return the flash address of the string.
+    const char* address() const { return ptr; }
+
+    /// Return the number of characters in the string.
+    std::size_t size() const { return strlen_P( ptr ); }
+
+    /// Return the character at the specified position.
+    char at( std::size_t position ) const
+    {
+      return static_cast<char>( pgm_read_byte( ptr + position ) );
+    }
+
+    /// Return \c true if the string contains the specified character.
+    bool contains( char c ) const;
+
+    /// Return \c true if the string is equal to the specified string,
+    /// ignoring the case of letters.
+    bool equalsIgnoreCase( const qsense::QString& other ) const;
+
+    /**
+     * @brief Copy part of the string to SRAM.  The copy is not
+     * terminated.
+     * @param dest The buffer to copy to.
+     * @param length The maximum number of characters to copy.
+     * @param position The position of the first character to copy.
+     * @return The number of characters copied.
+     */
+    std::size_t copy( char* dest, std::size_t length, std::size_t position = 0 ) const;
+
+    /// Write the string to the specified sink.
+    void write( Sink& sink ) const;
+
+    /// Return a copy of the string in SRAM.  Only for APIs that retain
+    /// the string, such as a connection to a server.
+    qsense::QString toString() const;
+
+#if defined( ARDUINO )
+    /// Return the string for use with the Arduino \c Print functions.
+    const __FlashStringHelper* helper() const
+    {
+      return reinterpret_cast<const __FlashStringHelper*>( ptr );
+    }
+#endif
+
+  private:
+    const char* ptr;
+  };
+
+
+  /// Write the flash string to the output stream without copying it to
+  /// SRAM as a whole.
+  std::ostream& operator << ( std::ostream& os, const FlashString& str );
+
+} // namespace qsense
+
+#endif // QSENSE_FLASHSTRING_H
@@ -15,20 +15,91 @@ limitations under the License.
 #include "HttpRequest.h"
 
 #if defined( ARDUINO )
+#include "../StandardCplusplus/cctype"
 #include "../StandardCplusplus/cstdio"
+#include "../StandardCplusplus/cstring"
+#include "../StandardCplusplus/iostream"
 #include "../StandardCplusplus/sstream"
 #else
+#include <cctype>
 #include <cstdio>
+#include <cstring>
+#include <iostream>
 #include <sstream>
 #endif
 
+namespace qsense
+{
+  namespace net
+  {
+    namespace data
+    {
+      /// Names of the well known headers in HeaderId order, each
+      /// terminated by a null character.
+      static const char headerNames[] PROGMEM =
+        "\0" "Authorization\0" "Content-Length\0" "Content-MD5\0"
+        "Content-Type\0" "Date\0" "Signature-Version\0" "User-Agent";
+
+      /// Characters that are always percent encoded in parameters.
+      static const char illegal[] PROGMEM = "%<>{}|\\\"^`";
+
+      /// Case insensitive comparison of header names.
+      bool sameName( const char* name, const QString& other )
+      {
+        if ( strlen( name ) != other.size() ) return false;
+
+        for ( std::size_t i = 0; i < other.size(); ++i )
+        {
+          if ( tolower( name[i] ) != tolower( other[i] ) ) return false;
+        }
+
+        return true;
+      }
+    }
+  }
+}
+
+using qsense::FlashString;
 using qsense::QString;
 using qsense::net::HttpRequest;
 
-const QString HttpRequest::ILLEGAL = "%<>{}|\\\"^`";
 
 HttpRequest::HttpRequest( const QString& path ) :
-  uri( path ), body(), parameters(), headers() {}
+  uri( path ), body(), parameters(), headerCount( 0 ), storageUsed( 0 ),
+  truncated( false ) {}
+
+
+HttpRequest::HttpRequest( const HttpRequest& request ) :
+  uri( request.uri ), body( request.body ), parameters( request.parameters ),
+  headerCount( request.headerCount ), storageUsed( request.storageUsed ),
+  truncated( request.truncated )
+{
+  memcpy( storage, request.storage, storageUsed );
+
+  // Point copied names and values at the storage of this request
+  const char* begin = request.storage;
+  const char* end = request.storage + storageUsed;
+  for ( uint16_t i = 0; i < headerCount; ++i )
+  {
+    headers[i] = request.headers[i];
+    if ( headers[i].name >= begin && headers[i].name < end )
+    {
+      headers[i].name = storage + ( headers[i].name - begin );
+    }
+    if ( headers[i].value >= begin && headers[i].value < end )
+    {
+      headers[i].value = storage + ( headers[i].value - begin );
+    }
+  }
+}
+
+
+FlashString HttpRequest::getHeaderName( HeaderId id )
+{
+  const char* name = data::headerNames;
+  for ( uint8_t i = 0; i < id; ++i ) name += strlen_P( name ) + 1;
+  return FlashString( name );
+}
 
 
 HttpRequest& HttpRequest::setBody( const QString& txt )
@@ -47,15 +118,131 @@ HttpRequest& HttpRequest::setParameter( const QString& key, const QString& value
 }
 
 
+HttpRequest& HttpRequest::setHeader( HeaderId id, const char* value )
+{
+  Header* header = find( id, NULL );
+  if ( header == NULL ) return *this;
+
+  header->value = value;
+  header->length = strlen( value );
+  return *this;
+}
+
+
+HttpRequest& HttpRequest::setHeader( HeaderId id, const QString& value )
+{
+  const uint16_t count = headerCount;
+  Header* header = find( id, NULL );
+  if ( header == NULL ) return *this;
+
+  copy( *header, value, headerCount > count );
+  return *this;
+}
+
+
 HttpRequest& HttpRequest::setHeader( const QString& key, const QString& value )
 {
-  Map::iterator iter = headers.find( key );
-  if ( iter != headers.end() ) headers.erase( iter );
-  headers.insert( std::pair<QString,QString>( key, value ) );
+  for ( uint8_t id = Authorization; id <= UserAgent; ++id )
+  {
+    if ( getHeaderName( static_cast<HeaderId>( id ) ).equalsIgnoreCase( key ) )
+    {
+      return setHeader( static_cast<HeaderId>( id ), value );
+    }
+  }
+
+  const uint16_t count = headerCount;
+  Header* header = find( CustomHeader, &key );
+  if ( header == NULL ) return *this;
+
+  if ( headerCount > count )
+  {
+    header->name = store( key.data(), key.size() );
+    if ( header->name == NULL )
+    {
+      --headerCount;
+      return *this;
+    }
+  }
+
+  copy( *header, value, headerCount > count );
   return *this;
 }
 
 
+const HttpRequest::Header* HttpRequest::getHeader( HeaderId id ) const
+{
+  for ( uint16_t i = 0; i < headerCount; ++i )
+  {
+    if ( headers[i].id == id ) return headers + i;
+  }
+
+  return NULL;
+}
+
+
+HttpRequest::Header* HttpRequest::find( HeaderId id, const QString* name )
+{
+  for ( uint16_t i = 0; i < headerCount; ++i )
+  {
+    if ( headers[i].id != id ) continue;
+    if ( name == NULL || data::sameName( headers[i].name, *name ) ) return headers + i;
+  }
+
+  if ( headerCount == QSENSE_HTTP_MAX_HEADERS )
+  {
+#if DEBUG
+    std::cout << F( "Header table full, dropping header" ) << std::endl;
+#endif
+    truncated = true;
+    return NULL;
+  }
+
+  Header& header = headers[headerCount++];
+  header.id = id;
+  header.name = NULL;
+  header.value = "";
+  header.length = 0;
+  return &header;
+}
+
+
+void HttpRequest::copy( Header& header, const QString& value, bool added )
+{
+  const char* data = store( value.data(), value.size() );
+  if ( data == NULL )
+  {
+    // A new header is dropped rather than sent without a value, an
+    // existing one keeps its previous value.
+    if ( added ) --headerCount;
+    return;
+  }
+
+  header.value = data;
+  header.length = value.size();
+}
+
+
+const char* HttpRequest::store( const char* data, std::size_t length )
+{
+  // Replaced values are not reclaimed, the storage only lives as long
+  // as the request.
+  if ( storageUsed + length + 1 > QSENSE_HTTP_HEADER_STORAGE )
+  {
+#if DEBUG
+    std::cout << F( "Header storage full, dropping header" ) << std::endl;
+#endif
+    truncated = true;
+    return NULL;
+  }
+
+  char* copy = storage + storageUsed;
+  memcpy( copy, data, length );
+  copy[length] = '\0';
+  storageUsed += length + 1;
+  return copy;
+}
+
+
 const QString HttpRequest::getParamters() const
 {
   std::stringstream ss;
@@ -96,7 +283,7 @@ QString HttpRequest::encode( const QString& str ) const
       encodedStr += c;
     }
     else if ( c <= 0x20 || c >= 0x7F ||
-      ILLEGAL.find(c) != QString::npos || '#' == c )
+      FlashString( data::illegal ).contains( c ) || '#' == c )
     {
       encodedStr += '%';
       toHex( (unsigned) (unsigned char) c, 2, encodedStr );
@@ -17,12 +17,29 @@ limitations under the License.
 
 #if defined( ARDUINO )
 #include "QSense.h"
+#include "FlashString.h"
 #include "../StandardCplusplus/map"
 #else
 #include <QSense.h>
+#include <FlashString.h>
 #include <map>
 #endif
 
+#ifndef QSENSE_HTTP_MAX_HEADERS
+// Maximum number of headers that may be added to a request.
+#define QSENSE_HTTP_MAX_HEADERS 8
+#endif
+
+#ifndef QSENSE_HTTP_HEADER_STORAGE
+// Number of bytes available to each request for header names and values
+// that must be copied.  Values that reference caller owned data use none.
+#if defined( ARDUINO )
+#define QSENSE_HTTP_HEADER_STORAGE 192
+#else
+#define QSENSE_HTTP_HEADER_STORAGE 1024
+#endif
+#endif
+
 namespace qsense
 {
   namespace net
@@ -31,19 +48,73 @@ namespace qsense
      * @brief A simple class that represents a HTTP request.  Request
      * encapsulates the URI path, any request parameters, header attributes,
      * body etc. as appropriate.
+     *
+     * Headers are held in a table of at most \c QSENSE_HTTP_MAX_HEADERS
+     * entries within the request, so that adding them does not allocate.
+     * Well known headers are identified by a {@link HeaderId}, and their
+     * values may reference data owned by the caller:
+     *
+     * \code
+     * HttpRequest request( "/rest/v1/provision/application/device/" );
+     * request.setHeader( HttpRequest::ContentType, "application/json" );
+     * request.setHeader( HttpRequest::Date, currentTime );
+     * \endcode
      */
     class HttpRequest
     {
     public:
-      /// Map used to represent request parameters and headers.
+      /// Map used to represent request parameters and response headers.
       typedef std::map<QString,QString> Map;
 
-      /// Constant iterator to access contents of the parameters and headers
+      /// Constant iterator to access contents of the parameters
       typedef Map::const_iterator Iterator;
 
+      /// Well known headers, whose names are not stored in the request.
+      enum HeaderId
+      {
+        CustomHeader = 0, Authorization, ContentLength, ContentMD5,
+        ContentType, Date, SignatureVersion, UserAgent
+      };
+
+      /// A header added to the request.  The value is either owned by the
+      /// caller, or a copy held in the storage of the request.
+      class Header
+      {
+      public:
+        /// Return the identifier of the header, \c CustomHeader if none.
+        HeaderId getId() const { return id; }
+
+        /// Return the name of a \c CustomHeader, or \c NULL for a well
+        /// known header.  See {@link HttpRequest#getHeaderName}.
+        const char* getName() const { return name; }
+
+        /// Return the value of the header.
+        const char* getValue() const { return value; }
+
+        /// Return the number of bytes in the value.
+        std::size_t getLength() const { return length; }
+
+      private:
+        friend class HttpRequest;
+
+        const char* name;
+        const char* value;
+        uint16_t length;
+        HeaderId id;
+      };
+
+      /// Constant iterator over the headers, in the order they were added.
+      typedef const Header* HeaderIterator;
+
+      /// Return the name of the specified well known header.
+      static qsense::FlashString getHeaderName( HeaderId id );
+
       /// Constructor.  Create a request for the specified server resource
       HttpRequest( const QString& uri );
 
+      /// Copy constructor.  Copied header values are copied again.
+      HttpRequest( const HttpRequest& request );
+
       /// Destructor.  No actions required.
       ~HttpRequest() {}
 
@@ -63,35 +134,59 @@ namespace qsense
       /// key, it will be replaced with the specified value.
       HttpRequest& setParameter( const QString& key, const QString& value );
 
+      /// Add the specified well known header to this request.  The value is
+      /// not copied, and must remain valid until the request is sent.  If
+      /// the header was already added, its value is replaced.
+      HttpRequest& setHeader( HeaderId id, const char* value );
+
+      /// Add the specified well known header to this request.  The value is
+      /// copied into the storage of the request.  If the header was already
+      /// added, its value is replaced.
+      HttpRequest& setHeader( HeaderId id, const QString& value );
+
       /// Add the specified key/value combination as a request attribute
-      /// to this request.  If a mapping already exists with the specified
-      /// key, it will be replaced with the specified value.
+      /// to this request.  Both are copied into the storage of the request,
+      /// unless the key names a well known header.  If a header already
+      /// exists with the specified key, it will be replaced with the
+      /// specified value.
       HttpRequest& setHeader( const QString& key, const QString& value );
 
+      /// Return the specified well known header, or \c NULL if not added.
+      const Header* getHeader( HeaderId id ) const;
+
+      /// Return \c true if a header was dropped as the header table or the
+      /// header storage was full.
+      bool headersTruncated() const { return truncated; }
+
       /// Return the requests parameters as a string.
       /// \b Note: A leading ? symbol will not be added, which is required
       /// for GET requests.  Calls must add if making a GET request.
       const QString getParamters() const;
 
-      /// Return a constant iterator to the beginning of the headers
-      /// map.
-      Iterator beginHeaders() const { return headers.begin(); }
+      /// Return a constant iterator to the beginning of the headers.
+      HeaderIterator beginHeaders() const { return headers; }
 
-      /// Return a constant iterator to the beginning of the headers
-      /// map.
-      Iterator endHeaders() const { return headers.end(); }
+      /// Return a constant iterator to the end of the headers.
+      HeaderIterator endHeaders() const { return headers + headerCount; }
 
     private:
+      HttpRequest& operator = ( const HttpRequest& );
+
+      Header* find( HeaderId id, const QString* name );
+      void copy( Header& header, const QString& value, bool added );
+      const char* store( const char* data, std::size_t length );
       void toHex( unsigned value, int width, QString& output ) const;
       QString encode( const QString& value ) const;
 
     private:
-      static const QString ILLEGAL;
-
       const QString uri;
       QString body;
       Map parameters;
-      Map headers;
+      Header headers[QSENSE_HTTP_MAX_HEADERS];
+      char storage[QSENSE_HTTP_HEADER_STORAGE];
+      uint16_t headerCount;
+      uint16_t storageUsed;
+      bool truncated;
     };
 
   } // namespace net
@@ -0,0 +1,216 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "JsonWriter.h"
+
+#if defined( ARDUINO )
+#include <avr/pgmspace.h>
+#include "NumberFormat.h"
+#include "../StandardCplusplus/cstring"
+#else
+#include <NumberFormat.h>
+#include <cstring>
+#endif
+
+namespace qsense
+{
+  namespace data
+  {
+    /// The character written after a backslash to escape each character,
+    /// \c 'u' for a \c \\u00XX escape, or \c 0 if it needs no escaping
+    const char escapes[256] PROGMEM =
+    {
+      'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'b', 't', 'n', 'u', 'f', 'r', 'u', 'u',
+      'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+      0, 0, '"', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, '\\', 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+    };
+
+    const char hexDigits[] PROGMEM = "0123456789abcdef";
+
+#if ! defined( ARDUINO )
+    /// Return \c true if any of the eight bytes is a control character,
+    /// a quote or a backslash
+    inline bool special( uint64_t word )
+    {
+      const uint64_t ones = 0x0101010101010101ULL;
+      const uint64_t highs = 0x8080808080808080ULL;
+
+      const uint64_t quotes = word ^ ( ones * '"' );
+      const uint64_t slashes = word ^ ( ones * '\\' );
+      return ( ( ( word - ones * 0x20 ) & ~word ) |
+          ( ( quotes - ones ) & ~quotes ) |
+          ( ( slashes - ones ) & ~slashes ) ) & highs;
+    }
+#endif
+  }
+}
+
+using qsense::JsonWriter;
+
+
+JsonWriter::JsonWriter( Sink& s ) :
+  sink( &s ), begin( buffer ), ptr( buffer ), end( buffer + bufferSize ),
+  flushed( 0 ), truncated( false ) {}
+
+
+JsonWriter::JsonWriter( char* b, std::size_t size ) :
+  sink( NULL ), begin( b ), ptr( b ), end( b + size ), flushed( 0 ),
+  truncated( false ) {}
+
+
+JsonWriter& JsonWriter::raw( const char* data, std::size_t length )
+{
+  // Long runs go to the sink directly rather than through the buffer
+  if ( sink != NULL && length >= bufferSize )
+  {
+    flush();
+    sink->write( data, length );
+    flushed += length;
+    return *this;
+  }
+
+  while ( length > 0 )
+  {
+    if ( ptr == end )
+    {
+      if ( sink == NULL )
+      {
+        truncated = true;
+        break;
+      }
+
+      flush();
+    }
+
+    const std::size_t count = ( length < std::size_t( end - ptr ) ) ? length : end - ptr;
+    memcpy( ptr, data, count );
+    ptr += count;
+    data += count;
+    length -= count;
+  }
+
+  return *this;
+}
+
+
+JsonWriter& JsonWriter::raw( const qsense::FlashString& text )
+{
+  std::size_t position = 0;
+  for ( ;; )
+  {
+    // Text that exactly fills the buffer is not truncated
+    if ( text.at( position ) == 0 ) break;
+
+    if ( ptr == end )
+    {
+      if ( sink == NULL )
+      {
+        truncated = true;
+        break;
+      }
+
+      flush();
+    }
+
+    const std::size_t count = text.copy( ptr, end - ptr, position );
+    if ( count == 0 ) break;
+    ptr += count;
+    position += count;
+  }
+
+  return *this;
+}
+
+
+JsonWriter& JsonWriter::string( const char* data, std::size_t length )
+{
+  raw( '"' );
+
+  const char* run = data;
+  const char* const last = data + length;
+
+  while ( data < last )
+  {
+#if ! defined( ARDUINO )
+    uint64_t word;
+    while ( last - data >= 8 )
+    {
+      memcpy( &word, data, sizeof( word ) );
+      if ( data::special( word ) ) break;
+      data += 8;
+    }
+
+    if ( data == last ) break;
+#endif
+
+    const char escape = static_cast<char>(
+        pgm_read_byte( data::escapes + static_cast<uint8_t>( *data ) ) );
+    if ( escape == 0 )
+    {
+      ++data;
+      continue;
+    }
+
+    raw( run, data - run );
+
+    char sequence[6] = { '\\', escape, '0', '0' };
+    std::size_t count = 2;
+    if ( escape == 'u' )
+    {
+      sequence[4] = static_cast<char>( pgm_read_byte( data::hexDigits + ( *data >> 4 ) ) );
+      sequence[5] = static_cast<char>( pgm_read_byte( data::hexDigits + ( *data & 0x0F ) ) );
+      count = 6;
+    }
+
+    raw( sequence, count );
+    run = ++data;
+  }
+
+  raw( run, data - run );
+  return raw( '"' );
+}
+
+
+JsonWriter& JsonWriter::number( float value )
+{
+  char digits[qsense::NumberFormat::bufferSize];
+  const std::size_t length = qsense::NumberFormat::format( value, digits );
+  if ( length == 0 ) return raw( F( "null" ) );
+  return raw( digits, length );
+}
+
+
+void JsonWriter::flush()
+{
+  if ( sink == NULL ) return;
+
+  const std::size_t length = ptr - begin;
+  if ( length > 0 ) sink->write( begin, length );
+
+  flushed += length;
+  ptr = begin;
+}
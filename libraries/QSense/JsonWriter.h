@@ -0,0 +1,125 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef QSENSE_JSONWRITER_H
+#define QSENSE_JSONWRITER_H
+
+#if defined( ARDUINO )
+#include "QSense.h"
+#include "FlashString.h"
+#include "Sink.h"
+#else
+#include <QSense.h>
+#include <FlashString.h>
+#include <Sink.h>
+#endif
+
+namespace qsense
+{
+  /**
+   * @brief Writes JSON text to a {@link Sink} or to a buffer supplied by
+   * the caller, without going through \c std::ostream formatting.
+   *
+   * Structural text is written as given with {@link #raw}, and strings are
+   * quoted and escaped with {@link #string}.  Characters are classified
+   * through a 256 entry table, so runs of characters that need no escaping
+   * are copied in bulk; the host build skips over them a word at a time.
+   * Output to a sink is staged in \c bufferSize bytes, and output to a
+   * buffer that does not fit is dropped and flagged:
+   *
+   * \code
+   * char buffer[128];
+   * JsonWriter writer( buffer, sizeof( buffer ) );
+   * writer.raw( '{' ).string( "key" ).raw( ':' ).string( value ).raw( '}' );
+   * if ( ! writer.isTruncated() ) send( buffer, writer.size() );
+   * \endcode
+   */
+  class JsonWriter
+  {
+  public:
+    /// Number of bytes staged before they are passed to the sink.
+    static const std::size_t bufferSize = 64;
+
+    /// Create a new writer that forwards to the specified sink.
+    JsonWriter( Sink& sink );
+
+    /// Create a new writer that writes to the specified buffer.
+    JsonWriter( char* buffer, std::size_t size );
+
+    /// Destructor.  Forwards any staged output to the sink.
+    ~JsonWriter() { flush(); }
+
+    /// Write the specified characters unchanged.
+    JsonWriter& raw( const char* data, std::size_t length );
+
+    /// Write the specified null terminated text unchanged.
+    JsonWriter& raw( const char* text ) { return raw( text, strlen( text ) ); }
+
+    /// Write the specified character unchanged.
+    JsonWriter& raw( char c ) { return raw( &c, 1 ); }
+
+    /// Write the specified flash string unchanged.
+    JsonWriter& raw( const FlashString& text );
+
+#if defined( ARDUINO )
+    /// Write text declared with the \c F macro unchanged.
+    JsonWriter& raw( const __FlashStringHelper* text )
+    {
+      return raw( FlashString( reinterpret_cast<const char*>( text ) ) );
+    }
+#endif
+
+    /// Write the specified characters as a quoted and escaped JSON string.
+    JsonWriter& string( const char* data, std::size_t length );
+
+    /// Write the specified null terminated text as a quoted and escaped
+    /// JSON string.
+    JsonWriter& string( const char* text ) { return string( text, strlen( text ) ); }
+
+    /// Write the specified text as a quoted and escaped JSON string.
+    JsonWriter& string( const qsense::QString& text )
+    {
+      return string( text.data(), text.size() );
+    }
+
+    /// Write the specified number in its shortest form, or \c null if it
+    /// is not finite.
+    JsonWriter& number( float value );
+
+    /// Pass the staged output to the sink.
+    void flush();
+
+    /// Return the number of bytes written.
+    std::size_t size() const { return flushed + ( ptr - begin ); }
+
+    /// Return \c true if output did not fit in the buffer supplied.
+    bool isTruncated() const { return truncated; }
+
+  private:
+    JsonWriter( const JsonWriter& );
+    JsonWriter& operator = ( const JsonWriter& );
+
+  private:
+    Sink* sink;
+    char* begin;
+    char* ptr;
+    char* end;
+    std::size_t flushed;
+    bool truncated;
+    char buffer[bufferSize];
+  };
+
+} // namespace qsense
+
+#endif // QSENSE_JSONWRITER_H
@@ -15,10 +15,9 @@ limitations under the License.
 #include "Location.h"
 
 #if defined( ARDUINO )
-#include "../StandardCplusplus/sstream"
+#include "JsonWriter.h"
 #else
-#include <string>
-#include <sstream>
+#include <JsonWriter.h>
 #endif
 
 using qsense::Location;
@@ -33,15 +32,26 @@ Location& Location::operator = ( const Location& location )
 
 const QString Location::toString() const
 {
-  std::stringstream ss;
-  ss << *this;
-  return ss.str();
+  QString str;
+  qsense::StringSink sink( str );
+  qsense::JsonWriter writer( sink );
+  writer << *this;
+  writer.flush();
+  return str;
 }
 
 
 std::ostream& qsense::operator << ( std::ostream& os, const Location& location )
 {
-  os << "{\"lat\": " << location.getLatitude() <<
-    ",\"lon\": " << location.getLongitude() << "}";
+  qsense::StreamSink sink( os );
+  qsense::JsonWriter writer( sink );
+  writer << location;
   return os;
 }
+
+
+qsense::JsonWriter& qsense::operator << ( JsonWriter& writer, const Location& location )
+{
+  return writer.raw( F( "{\"lat\": " ) ).number( location.getLatitude() ).
+    raw( F( ",\"lon\": " ) ).number( location.getLongitude() ).raw( '}' );
+}
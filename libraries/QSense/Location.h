@@ -65,8 +65,13 @@ namespace qsense
     float longitude;
   };
 
+  class JsonWriter;
+
   /// Serialise the specified location to the output stream
   std::ostream& operator << ( std::ostream& os, const qsense::Location& location );
+
+  /// Serialise the specified location as JSON to the writer
+  JsonWriter& operator << ( JsonWriter& writer, const qsense::Location& location );
 }
 
 #endif // QSENSE_LOCATION_H
@@ -324,3 +324,12 @@ QString MD5::compute( const QString& payload )
 
   return md5::toHex( hash, MD5_HASH_LENGTH );
 }
+
+
+QString MD5::finish()
+{
+  Byte hash[MD5_HASH_LENGTH];
+  finish( hash );
+
+  return md5::toHex( hash, MD5_HASH_LENGTH );
+}
@@ -77,6 +77,22 @@ namespace qsense
       /** Compute MD5 digest for specified data and return base64 encoded string */
       qsense::QString compute( const qsense::QString& input );
 
+      /**
+       * Incremental interface.  Invoke {@link #init}, then {@link #update}
+       * as data becomes available, and finally {@link #finish} to
+       * retrieve the digest in the same format as {@link #compute}.
+       */
+      void update( const char* input, std::size_t inputLen )
+      {
+        update( reinterpret_cast<const Byte*>( input ), Word( inputLen ) );
+      }
+
+      /** Finish an incremental computation and return the encoded digest */
+      qsense::QString finish();
+
+      /** MD5 initialization. Begins an MD5 operation, writing a new context.  */
+      void init();
+
     private:
       /** MD5 encoding context */
       struct Context
@@ -89,9 +105,6 @@ namespace qsense
         Byte buffer[64];
       };
 
-      /** MD5 initialization. Begins an MD5 operation, writing a new context.  */
-      void init();
-
       /**
        * MD5 block update operation. Continues an MD5 message-digest
        * operation, processing another message block, and updating the
@@ -0,0 +1,425 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "NumberFormat.h"
+
+#if defined( ARDUINO )
+#include <avr/pgmspace.h>
+#include "../StandardCplusplus/cstring"
+#else
+#include <cstring>
+#endif
+
+namespace qsense
+{
+  namespace grisu
+  {
+    /// A floating point number with a 64 bit significand, f * 2^e
+    struct DiyFp
+    {
+      uint64_t f;
+      int16_t e;
+    };
+
+    /// Normalised significands of 10^q for q from minPower, rounded to nearest.
+    static const int16_t minPower = -37;
+    static const uint64_t significands[] PROGMEM =
+    {
+        0x881CEA14545C7575ULL, 0xAA242499697392D3ULL, 0xD4AD2DBFC3D07788ULL,
+        0x84EC3C97DA624AB5ULL, 0xA6274BBDD0FADD62ULL, 0xCFB11EAD453994BAULL,
+        0x81CEB32C4B43FCF5ULL, 0xA2425FF75E14FC32ULL, 0xCAD2F7F5359A3B3EULL,
+        0xFD87B5F28300CA0EULL, 0x9E74D1B791E07E48ULL, 0xC612062576589DDBULL,
+        0xF79687AED3EEC551ULL, 0x9ABE14CD44753B53ULL, 0xC16D9A0095928A27ULL,
+        0xF1C90080BAF72CB1ULL, 0x971DA05074DA7BEFULL, 0xBCE5086492111AEBULL,
+        0xEC1E4A7DB69561A5ULL, 0x9392EE8E921D5D07ULL, 0xB877AA3236A4B449ULL,
+        0xE69594BEC44DE15BULL, 0x901D7CF73AB0ACD9ULL, 0xB424DC35095CD80FULL,
+        0xE12E13424BB40E13ULL, 0x8CBCCC096F5088CCULL, 0xAFEBFF0BCB24AAFFULL,
+        0xDBE6FECEBDEDD5BFULL, 0x89705F4136B4A597ULL, 0xABCC77118461CEFDULL,
+        0xD6BF94D5E57A42BCULL, 0x8637BD05AF6C69B6ULL, 0xA7C5AC471B478423ULL,
+        0xD1B71758E219652CULL, 0x83126E978D4FDF3BULL, 0xA3D70A3D70A3D70AULL,
+        0xCCCCCCCCCCCCCCCDULL, 0x8000000000000000ULL, 0xA000000000000000ULL,
+        0xC800000000000000ULL, 0xFA00000000000000ULL, 0x9C40000000000000ULL,
+        0xC350000000000000ULL, 0xF424000000000000ULL, 0x9896800000000000ULL,
+        0xBEBC200000000000ULL, 0xEE6B280000000000ULL, 0x9502F90000000000ULL,
+        0xBA43B74000000000ULL, 0xE8D4A51000000000ULL, 0x9184E72A00000000ULL,
+        0xB5E620F480000000ULL, 0xE35FA931A0000000ULL, 0x8E1BC9BF04000000ULL,
+        0xB1A2BC2EC5000000ULL, 0xDE0B6B3A76400000ULL, 0x8AC7230489E80000ULL,
+        0xAD78EBC5AC620000ULL, 0xD8D726B7177A8000ULL, 0x878678326EAC9000ULL,
+        0xA968163F0A57B400ULL, 0xD3C21BCECCEDA100ULL, 0x84595161401484A0ULL,
+        0xA56FA5B99019A5C8ULL, 0xCECB8F27F4200F3AULL, 0x813F3978F8940984ULL,
+        0xA18F07D736B90BE5ULL, 0xC9F2C9CD04674EDFULL, 0xFC6F7C4045812296ULL,
+        0x9DC5ADA82B70B59EULL, 0xC5371912364CE305ULL, 0xF684DF56C3E01BC7ULL,
+        0x9A130B963A6C115CULL, 0xC097CE7BC90715B3ULL, 0xF0BDC21ABB48DB20ULL,
+        0x96769950B50D88F4ULL, 0xBC143FA4E250EB31ULL, 0xEB194F8E1AE525FDULL,
+        0x92EFD1B8D0CF37BEULL, 0xB7ABC627050305AEULL, 0xE596B7B0C643C719ULL,
+        0x8F7E32CE7BEA5C70ULL, 0xB35DBF821AE4F38CULL, 0xE0352F62A19E306FULL
+    };
+
+    /// Binary exponents of the powers in significands.
+    static const int16_t exponents[] PROGMEM =
+    {
+        -186, -183, -180, -176, -173, -170, -166, -163, -160, -157, -153, -150,
+        -147, -143, -140, -137, -133, -130, -127, -123, -120, -117, -113, -110,
+        -107, -103, -100, -97, -93, -90, -87, -83, -80, -77, -73, -70,
+        -67, -63, -60, -57, -54, -50, -47, -44, -40, -37, -34, -30,
+        -27, -24, -20, -17, -14, -10, -7, -4, 0, 3, 6, 10,
+        13, 16, 20, 23, 26, 30, 33, 36, 39, 43, 46, 49,
+        53, 56, 59, 63, 66, 69, 73, 76, 79, 83, 86, 89
+    };
+
+    static const uint32_t powers10[] PROGMEM =
+    {
+      1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL, 1000000UL, 10000000UL,
+      100000000UL, 1000000000UL
+    };
+
+    /// Read a value from flash, independent of the byte order.
+    template <typename T>
+    T readFlash( const T* ptr )
+    {
+      uint8_t bytes[sizeof( T )];
+      const uint8_t* src = reinterpret_cast<const uint8_t*>( ptr );
+      for ( uint8_t i = 0; i < sizeof( T ); ++i ) bytes[i] = pgm_read_byte( src + i );
+
+      T value;
+      memcpy( &value, bytes, sizeof( T ) );
+      return value;
+    }
+
+    uint32_t pow10( int8_t n ) { return readFlash( powers10 + n ); }
+
+    DiyFp normalize( DiyFp v )
+    {
+      while ( ( v.f & ( uint64_t( 1 ) << 63 ) ) == 0 )
+      {
+        v.f <<= 1;
+        --v.e;
+      }
+
+      return v;
+    }
+
+    /// The upper 64 bits of the product, rounded.
+    DiyFp multiply( const DiyFp& x, const DiyFp& y )
+    {
+      const uint64_t mask = 0xFFFFFFFFULL;
+      const uint64_t a = x.f >> 32, b = x.f & mask;
+      const uint64_t c = y.f >> 32, d = y.f & mask;
+      const uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+
+      uint64_t middle = ( bd >> 32 ) + ( ad & mask ) + ( bc & mask );
+      middle += uint64_t( 1 ) << 31;
+
+      DiyFp product = { ac + ( ad >> 32 ) + ( bc >> 32 ) + ( middle >> 32 ),
+        int16_t( x.e + y.e + 64 ) };
+      return product;
+    }
+
+    /// Move the last digit towards the value while it stays in range.
+    void round( char* buffer, int8_t length, uint64_t delta, uint64_t rest,
+      uint64_t tenKappa, uint64_t distance )
+    {
+      while ( rest < distance && delta - rest >= tenKappa &&
+          ( rest + tenKappa < distance ||
+            distance - rest > rest + tenKappa - distance ) )
+      {
+        --buffer[length - 1];
+        rest += tenKappa;
+      }
+    }
+
+    /// Generate the shortest digits within delta of the upper boundary.
+    void generate( const DiyFp& w, const DiyFp& upper, uint64_t delta,
+      char* buffer, int8_t& length, int16_t& k )
+    {
+      const DiyFp one = { uint64_t( 1 ) << -upper.e, upper.e };
+      const uint64_t distance = upper.f - w.f;
+
+      uint32_t p1 = uint32_t( upper.f >> -one.e );
+      uint64_t p2 = upper.f & ( one.f - 1 );
+
+      int8_t kappa = 1;
+      while ( kappa < 10 && p1 >= pow10( kappa ) ) ++kappa;
+
+      length = 0;
+      while ( kappa > 0 )
+      {
+        const uint32_t div = pow10( kappa - 1 );
+        const uint32_t d = p1 / div;
+        p1 %= div;
+        if ( d || length ) buffer[length++] = static_cast<char>( '0' + d );
+        --kappa;
+
+        const uint64_t rest = ( uint64_t( p1 ) << -one.e ) + p2;
+        if ( rest <= delta )
+        {
+          k += kappa;
+          round( buffer, length, delta, rest, uint64_t( pow10( kappa ) ) << -one.e, distance );
+          return;
+        }
+      }
+
+      for ( ;; )
+      {
+        p2 *= 10;
+        delta *= 10;
+        const char d = static_cast<char>( p2 >> -one.e );
+        if ( d || length ) buffer[length++] = static_cast<char>( '0' + d );
+        p2 &= one.f - 1;
+        --kappa;
+
+        if ( p2 < delta )
+        {
+          k += kappa;
+          round( buffer, length, delta, p2, one.f, ( -kappa < 10 ) ? distance * pow10( -kappa ) : 0 );
+          return;
+        }
+      }
+    }
+
+    /// Write the digits d1..dn * 10^exponent in fixed or exponent notation.
+    std::size_t layout( char* out, const char* digits, int8_t length, int16_t exponent )
+    {
+      char* ptr = out;
+      const int16_t point = length + exponent;
+
+      if ( point > 0 && point <= 9 )
+      {
+        for ( int16_t i = 0; i < point; ++i ) *ptr++ = ( i < length ) ? digits[i] : '0';
+        if ( length > point )
+        {
+          *ptr++ = '.';
+          for ( int16_t i = point; i < length; ++i ) *ptr++ = digits[i];
+        }
+      }
+      else if ( point <= 0 && point > -5 )
+      {
+        *ptr++ = '0';
+        *ptr++ = '.';
+        for ( int16_t i = point; i < 0; ++i ) *ptr++ = '0';
+        for ( int8_t i = 0; i < length; ++i ) *ptr++ = digits[i];
+      }
+      else
+      {
+        *ptr++ = digits[0];
+        if ( length > 1 )
+        {
+          *ptr++ = '.';
+          for ( int8_t i = 1; i < length; ++i ) *ptr++ = digits[i];
+        }
+
+        *ptr++ = 'e';
+        int16_t e = point - 1;
+        if ( e < 0 )
+        {
+          *ptr++ = '-';
+          e = -e;
+        }
+        if ( e >= 10 ) *ptr++ = static_cast<char>( '0' + e / 10 );
+        *ptr++ = static_cast<char>( '0' + e % 10 );
+      }
+
+      return ptr - out;
+    }
+  }
+}
+
+using qsense::NumberFormat;
+
+
+bool NumberFormat::digits( float value, char* buffer, int8_t& length, int16_t& exponent )
+{
+  using namespace qsense::grisu;
+
+  uint32_t bits;
+  memcpy( &bits, &value, sizeof( bits ) );
+
+  const uint32_t mantissa = bits & 0x7FFFFFUL;
+  const int16_t biased = int16_t( ( bits >> 23 ) & 0xFF );
+  if ( biased == 0xFF ) return false;
+
+  if ( biased == 0 && mantissa == 0 )
+  {
+    buffer[0] = '0';
+    length = 1;
+    exponent = 0;
+    return true;
+  }
+
+  DiyFp v;
+  if ( biased == 0 )
+  {
+    v.f = mantissa;
+    v.e = -149;
+  }
+  else
+  {
+    v.f = mantissa | 0x800000UL;
+    v.e = int16_t( biased - 150 );
+  }
+
+  // Boundaries half way to the neighbouring floats, the lower one is
+  // closer at powers of two.
+  DiyFp upper = { ( v.f << 1 ) + 1, int16_t( v.e - 1 ) };
+  upper = normalize( upper );
+
+  DiyFp lower;
+  if ( mantissa == 0 && biased > 1 )
+  {
+    lower.f = ( v.f << 2 ) - 1;
+    lower.e = int16_t( v.e - 2 );
+  }
+  else
+  {
+    lower.f = ( v.f << 1 ) - 1;
+    lower.e = int16_t( v.e - 1 );
+  }
+  lower.f <<= lower.e - upper.e;
+  lower.e = upper.e;
+
+  const DiyFp w = normalize( v );
+
+  // Scale by 10^q so that the integer part of the upper boundary fits
+  // in 32 bits: -59 <= e <= -32 after the multiplication.
+  const int16_t x = int16_t( -60 - upper.e );
+  int16_t q = int16_t( ( int32_t( x ) * 1233 ) / 4096 );
+  if ( x > 0 && int32_t( q ) * 4096 < int32_t( x ) * 1233 ) ++q;
+
+  const DiyFp c = { readFlash( significands + q - minPower ),
+    readFlash( exponents + q - minPower ) };
+
+  const DiyFp scaled = multiply( w, c );
+  DiyFp high = multiply( upper, c );
+  DiyFp low = multiply( lower, c );
+
+  // Text exactly half way to a neighbour parses to the float with the
+  // even mantissa, so the boundaries (known to within a unit) are
+  // included for even mantissas, and excluded for odd ones.
+  if ( v.f & 1 )
+  {
+    ++low.f;
+    --high.f;
+  }
+  else
+  {
+    --low.f;
+    ++high.f;
+  }
+
+  exponent = int16_t( -q );
+  generate( scaled, high, high.f - low.f, buffer, length, exponent );
+  return true;
+}
+
+
+std::size_t NumberFormat::format( float value, char* buffer )
+{
+  char digitBuffer[20];
+  int8_t length;
+  int16_t exponent;
+
+  uint32_t bits;
+  memcpy( &bits, &value, sizeof( bits ) );
+
+  const bool negative = ( bits & 0x80000000UL ) != 0;
+  if ( ! digits( negative ? -value : value, digitBuffer, length, exponent ) ) return 0;
+
+  char* ptr = buffer;
+  if ( negative ) *ptr++ = '-';
+  return ( ptr - buffer ) + grisu::layout( ptr, digitBuffer, length, exponent );
+}
+
+
+std::size_t NumberFormat::format( float value, int8_t decimals, char* buffer )
+{
+  if ( decimals < 0 ) return format( value, buffer );
+  if ( decimals > maxDecimals ) decimals = maxDecimals;
+
+  char digitBuffer[21];
+  int8_t length;
+  int16_t exponent;
+
+  const bool negative = value < 0;
+  if ( ! digits( negative ? -value : value, digitBuffer + 1, length, exponent ) ) return 0;
+
+  char* d = digitBuffer + 1;
+  int16_t point = length + exponent;
+  if ( point > 9 ) return format( value, buffer );
+
+  // Round the shortest digits to the requested decimal places
+  const int16_t keep = point + decimals;
+  if ( keep < 0 ) length = 0;
+  else if ( keep < length )
+  {
+    const bool up = d[keep] >= '5';
+    length = int8_t( keep );
+
+    if ( up )
+    {
+      int8_t i = length - 1;
+      while ( i >= 0 && d[i] == '9' ) d[i--] = '0';
+
+      if ( i >= 0 ) ++d[i];
+      else
+      {
+        *--d = '1';
+        ++length;
+        ++point;
+      }
+    }
+  }
+
+  char* ptr = buffer;
+  bool zero = true;
+  for ( int8_t i = 0; i < length; ++i ) if ( d[i] != '0' ) zero = false;
+  if ( negative && ! zero ) *ptr++ = '-';
+
+  if ( point <= 0 ) *ptr++ = '0';
+  for ( int16_t i = 0; i < point; ++i ) *ptr++ = ( i < length ) ? d[i] : '0';
+
+  if ( decimals > 0 )
+  {
+    *ptr++ = '.';
+    for ( int16_t i = point; i < point + decimals; ++i )
+    {
+      *ptr++ = ( i >= 0 && i < length ) ? d[i] : '0';
+    }
+  }
+
+  return ptr - buffer;
+}
+
+
+std::size_t NumberFormat::format( int32_t value, char* buffer )
+{
+  char* ptr = buffer;
+  uint32_t magnitude = uint32_t( value );
+  if ( value < 0 )
+  {
+    *ptr++ = '-';
+    magnitude = 0 - magnitude;
+  }
+
+  char digits[10];
+  int8_t count = 0;
+  do
+  {
+    digits[count++] = static_cast<char>( '0' + magnitude % 10 );
+    magnitude /= 10;
+  }
+  while ( magnitude > 0 );
+
+  while ( count > 0 ) *ptr++ = digits[--count];
+  return ptr - buffer;
+}
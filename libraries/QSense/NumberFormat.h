@@ -0,0 +1,84 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef QSENSE_NUMBERFORMAT_H
+#define QSENSE_NUMBERFORMAT_H
+
+#if defined( ARDUINO )
+#include "QSense.h"
+#else
+#include <QSense.h>
+#endif
+
+namespace qsense
+{
+  /**
+   * @brief Formats numbers as JSON number text into a caller supplied
+   * buffer.  No streams, \c printf or heap allocations are used.
+   *
+   * Floats are written with the fewest significant digits that parse
+   * back to the same float (at most 9), using the Grisu2 algorithm with
+   * 64 bit integer arithmetic only, since \c double is no wider than
+   * \c float on AVR.  Values from \c 1e-5 up to \c 1e9 are written in
+   * fixed notation, others in exponent notation:
+   *
+   * \code
+   * char buffer[NumberFormat::bufferSize];
+   * std::size_t length = NumberFormat::format( 21.5f, buffer );  // "21.5"
+   * length = NumberFormat::format( 21.46f, 1, buffer );          // "21.5"
+   * \endcode
+   */
+  class NumberFormat
+  {
+  public:
+    /// Size of the buffer required by the format functions.
+    static const std::size_t bufferSize = 24;
+
+    /// Maximum number of decimal places that may be requested.
+    static const int8_t maxDecimals = 9;
+
+    /**
+     * @brief Format the float in the shortest form that round trips.
+     * @param value The value to format.
+     * @param buffer The buffer of at least \c bufferSize bytes to write to.
+     *   The text is not null terminated.
+     * @return The number of characters written, \c 0 if the value is not
+     *   a finite number (JSON has no representation for these).
+     */
+    static std::size_t format( float value, char* buffer );
+
+    /**
+     * @brief Format the float rounded to the specified decimal places, in
+     * fixed notation.  Values of \c 1e9 or more, for which fixed notation
+     * would be too long, are formatted as with {@link #format(float,char*)}.
+     * @param value The value to format.
+     * @param decimals The number of decimal places, up to \c maxDecimals.
+     *   Negative for the shortest form.
+     * @param buffer The buffer of at least \c bufferSize bytes to write to.
+     * @return The number of characters written, \c 0 if the value is not
+     *   a finite number.
+     */
+    static std::size_t format( float value, int8_t decimals, char* buffer );
+
+    /// Format the integer in decimal.  Returns the number of characters
+    /// written to the buffer of at least \c bufferSize bytes.
+    static std::size_t format( int32_t value, char* buffer );
+
+  private:
+    static bool digits( float value, char* digits, int8_t& length, int16_t& exponent );
+  };
+
+} // namespace qsense
+
+#endif // QSENSE_NUMBERFORMAT_H
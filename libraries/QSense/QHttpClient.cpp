@@ -16,14 +16,20 @@ limitations under the License.
 
 #if defined( ARDUINO )
 #include <WiFiClient.h>
+#if USE_Ethernet_Shield_V2
+#include <DnsV2_0.h>
+#endif
 #include "../StandardCplusplus/iostream"
 #else
-#include <vector>
 #include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 
 #include <Poco/Net/StreamSocket.h>
+#include <net/DateTime.h>
 #endif
 
 namespace qsense
@@ -34,6 +40,9 @@ namespace qsense
     {
       bool networkTypeInitialised = false;
       qsense::net::NetworkType networkType;
+
+      /// Number of connections and requests abandoned, by HttpClient::Error
+      uint16_t errors[HttpClient::ReceiveTimeout + 1];
     }
 
 #ifndef ARDUINO
@@ -44,14 +53,24 @@ namespace qsense
 
       int16_t connect( const QString& srvr, uint16_t port )
       {
-        socket.connect( Poco::Net::SocketAddress( srvr, port ) );
+        const Poco::Net::SocketAddress address( srvr, port );
+        if ( deadline == 0 ) socket.connect( address );
+        else socket.connect( address, Poco::Timespan( 0, 1000L * int32_t( deadline - millis() ) ) );
         socket.setNoDelay( true );
         return 1;
       }
 
+      void setDeadline( uint32_t d ) { deadline = d; }
+
       bool connected()
       {
-        return ( socket.impl()->initialized() || ( current < buffer.size() ) );
+        return ( socket.impl()->initialized() || ( head != tail ) );
+      }
+
+      void stop()
+      {
+        socket.close();
+        head = tail = 0;
       }
 
       void print( const QString& str )
@@ -74,88 +93,293 @@ namespace qsense
         println( ss.str() );
       }
 
+      std::size_t write( const uint8_t* data, std::size_t length )
+      {
+        return socket.sendBytes( data, length );
+      }
+
+      /// Return the number of bytes that may be read without blocking.
+      /// Unlike {@link #read()} this does not receive into the ring, so
+      /// that bulk reads copy the data only once, from the socket.
       int available()
       {
-        populate();
-        return buffer.size() - current;
+        if ( head != tail ) return tail - head;
+        if ( ! socket.impl()->initialized() ) return 0;
+        if ( ! socket.poll( Poco::Timespan(), Poco::Net::StreamSocket::SELECT_READ ) ) return 0;
+
+        // Readable with nothing to read is the server closing the connection
+        const int count = socket.available();
+        if ( count <= 0 ) socket.close();
+        return ( count > 0 ) ? count : 0;
       }
 
-      char read()
+      int read()
       {
         populate();
-        return ( current < buffer.size() ) ? buffer[current++] : -1;
+        return ( head != tail ) ? ring[head++ % ringSize] : -1;
       }
 
-      void populate()
+      int read( uint8_t* data, std::size_t length )
       {
-        if ( ! socket.impl()->initialized() ) return;
+        // Nothing buffered, receive straight into the caller's buffer
+        if ( head == tail )
+        {
+          const int count = receive( data, length );
+          return ( count > 0 ) ? count : -1;
+        }
 
-        int count = 1;
-        while ( count )
+        std::size_t count = 0;
+        while ( count < length && head != tail )
         {
-          char bytes[8192];
-          count = socket.receiveBytes( bytes, 8192 );
-          for ( int i = 0; i < count; ++i ) buffer.push_back( bytes[i] );
+          const std::size_t offset = head % ringSize;
+          std::size_t size = std::min( length - count, std::size_t( tail - head ) );
+          size = std::min( size, ringSize - offset );
+
+          memcpy( data + count, ring + offset, size );
+          head += size;
+          count += size;
         }
 
-        socket.close();
+        return count;
+      }
+
+
+      /// Receive the data available into the free space in the ring
+      /// buffer without blocking.  The socket is left open until the
+      /// server closes it, so that it may be reused for further requests.
+      void populate()
+      {
+        if ( head == tail ) head = tail = 0;
+
+        const std::size_t space = ringSize - ( tail - head );
+        if ( space == 0 ) return;
+
+        const std::size_t offset = tail % ringSize;
+        const int count = receive( ring + offset, std::min( space, ringSize - offset ) );
+        if ( count > 0 ) tail += count;
+      }
+
+      /// Receive up to \c length bytes if any are available.  Callers
+      /// wait for data against their deadline, so this never blocks.
+      int receive( uint8_t* data, std::size_t length )
+      {
+        if ( ! socket.impl()->initialized() ) return 0;
+        if ( ! socket.poll( Poco::Timespan(), Poco::Net::StreamSocket::SELECT_READ ) ) return 0;
+
+        const int count = socket.receiveBytes( data, length );
+        if ( count <= 0 ) socket.close();
+        return count;
       }
 
     private:
-      uint32_t current = 0;
-      std::vector<char> buffer;
+      /// Size of the receive ring buffer, a power of two.
+      static const std::size_t ringSize = 8192;
+
+      uint8_t ring[ringSize];
+      std::size_t head = 0;
+      std::size_t tail = 0;
+      uint32_t deadline = 0;
       Poco::Net::StreamSocket socket;
     };
 #endif
 
+    namespace http
+    {
+#if defined( ARDUINO ) && USE_Ethernet_Shield_V2
+      /// The last host name resolved, since event requests are always
+      /// made to the same host.
+      struct ResolvedHost
+      {
+        QString host;
+        IPAddress address;
+        uint32_t expires;
+      };
+
+      inline ResolvedHost& resolved()
+      {
+        static ResolvedHost cache;
+        return cache;
+      }
+
+      /// Discard the cached address, so that the next connection resolves
+      /// the host name again.
+      inline void forget() { resolved().host.clear(); }
+
+      /// Resolve the host name, reusing the cached address for up to
+      /// \c QSENSE_DNS_TTL milliseconds.
+      inline bool resolve( const QString& host, IPAddress& address )
+      {
+        ResolvedHost& cache = resolved();
+
+        if ( host != cache.host || int32_t( millis() - cache.expires ) >= 0 )
+        {
+          // Resolve into a local so that a failed lookup leaves the cache intact
+          IPAddress result;
+          DNSClient dns;
+          dns.begin( ::Ethernet.dnsServerIP() );
+          if ( dns.getHostByName( host.c_str(), result ) != 1 ) return false;
+
+          cache.host = host;
+          cache.address = result;
+          cache.expires = millis() + QSENSE_DNS_TTL;
+        }
+
+        address = cache.address;
+        return true;
+      }
+
+      inline int16_t beginConnect( EthernetClient& client, const QString& host, uint16_t port )
+      {
+        IPAddress address;
+        if ( ! resolve( host, address ) ) return 0;
+
+        const int16_t result = client.beginConnect( address, port );
+        if ( ! result ) forget();
+        return result;
+      }
+
+      inline bool isConnecting( EthernetClient& client )
+      {
+        if ( client.connecting() ) return true;
+
+        // The host may have moved, resolve it again for the next connection
+        if ( ! client.connected() ) forget();
+        return false;
+      }
+
+      inline void setDeadline( EthernetClient& client, uint32_t deadline ) { client.setDeadline( deadline ); }
+
+      inline bool timedOut( EthernetClient& client ) { return client.timedOut(); }
+#endif
+
+#ifndef ARDUINO
+      inline void setDeadline( NetworkClient& client, uint32_t deadline ) { client.setDeadline( deadline ); }
+#endif
+
+      /// Network libraries without support for connecting in the background
+      template <typename C>
+      int16_t beginConnect( C& client, const QString& host, uint16_t port )
+      {
+        return client.connect( host.c_str(), port );
+      }
+
+      template <typename C>
+      bool isConnecting( C& ) { return false; }
+
+      /// Network libraries without support for deadlines
+      template <typename C>
+      void setDeadline( C&, uint32_t ) {}
+
+      template <typename C>
+      bool timedOut( C& ) { return false; }
+
+      /// Collects the response headers into a map.
+      struct HeaderMap : ResponseParser::Handler
+      {
+        void header( const char* name, const char* value )
+        {
+          map.insert( std::pair<QString,QString>( name, value ) );
+        }
+
+        HttpRequest::Map map;
+      };
+
+      /// Collects the response body into a string.
+      struct BodyString : ResponseParser::Handler
+      {
+        void body( const char* data, std::size_t length ) { content.append( data, length ); }
+
+        QString content;
+      };
+    }
+
     template <typename C>
     class HttpClientImpl : public HttpClient, C
     {
     public:
-      HttpClientImpl() : HttpClient(), C(), server() {}
+      HttpClientImpl() : HttpClient(), C(), server(),
+        parser(), timeout( QSENSE_REQUEST_TIMEOUT ), deadline( 0 ),
+        error( NoError ), keepAlive( false ), reusable( false ),
+        rxStart( 0 ), rxEnd( 0 ), txLength( 0 ) {}
 
       int16_t connect( const QString& srvr, uint16_t port )
       {
         server = srvr;
-        return C::connect( server.c_str(), port );
+        rxStart = rxEnd = 0;
+        txLength = 0;
+        startDeadline();
+
+        const int16_t result = C::connect( server.c_str(), port );
+        if ( ! result && http::timedOut( static_cast<C&>( *this ) ) ) abandon( ConnectTimeout );
+        return result;
       }
 
 #if defined( ARDUINO )
       int16_t connect( const IPAddress& srvr, uint16_t port )
       {
-        return C::connect( srvr, port );
+        rxStart = rxEnd = 0;
+        txLength = 0;
+        startDeadline();
+
+        const int16_t result = C::connect( srvr, port );
+        if ( ! result && http::timedOut( static_cast<C&>( *this ) ) ) abandon( ConnectTimeout );
+        return result;
       }
 
-      uint8_t connected() { return C::connected(); }
+      uint8_t connected() { return ( rxStart < rxEnd ) || C::connected(); }
 #else
-      bool connected() { return C::connected(); }
+      bool connected() { return ( rxStart < rxEnd ) || C::connected(); }
 #endif
 
+      int16_t beginConnect( const QString& srvr, uint16_t port )
+      {
+        server = srvr;
+        rxStart = rxEnd = 0;
+        txLength = 0;
+        startDeadline();
+        return http::beginConnect( static_cast<C&>( *this ), server, port );
+      }
+
+      bool isConnecting() { return http::isConnecting( static_cast<C&>( *this ) ); }
+
+      void stop()
+      {
+        reusable = false;
+        rxStart = rxEnd = 0;
+        txLength = 0;
+        C::stop();
+      }
+
+      void setKeepAlive( bool flag ) { keepAlive = flag; }
+
+      void setRequestTimeout( uint32_t milliseconds ) { timeout = milliseconds; }
+
+      Error getError() const { return error; }
+
+      bool isReusable() const { return reusable; }
+
       uint16_t get( const HttpRequest& request )
       {
         uint16_t status = 0;
+        startRequest();
 
-        C::print( F( "GET " ) );
+        print( F( "GET " ) );
 
-        C::print( request.getUri().c_str() );
+        print( request.getUri().c_str() );
         const QString& parameters = request.getParamters();
         if ( parameters.size() > 0 )
         {
-          C::print( F( "?" ) );
-          C::print( parameters.c_str() );
+          print( F( "?" ) );
+          print( parameters.c_str() );
         }
 
-        C::println( F( " HTTP/1.1" ) );
-        C::print( F( "Host: " ) );
+        println( F( " HTTP/1.1" ) );
+        print( F( "Host: " ) );
 
-        C::println( server.c_str() );
-        writeHeaders( request );
+        println( server.c_str() );
+        writeHeaders( request, ! keepAlive );
 
-        if ( connected() )
-        {
-          const QString& line = readLine();
-          if ( line.size() > 14 ) status =  atoi( line.substr( 9, 3 ).c_str() );
-        }
+        if ( connected() ) status = readStatus();
 
         return status;
       }
@@ -175,51 +399,107 @@ namespace qsense
       {
         uint16_t status = 0;
 
-        C::print( method.c_str() );
-        C::print( " " );
-
-        C::print( request.getUri().c_str() );
-        C::println( F( " HTTP/1.1" ) );
-        C::print( F( "Host: " ) );
-        C::println( server.c_str() );
+        writeHead( method, request );
 
         if ( request.getBody().size() > 0 )
         {
-          C::print( F( "Content-Length: " ) );
-          C::println( request.getBody().size() );
+          // Exactly Content-Length bytes, trailing bytes would be read
+          // as the start of the next request on a keep-alive connection.
+          print( request.getBody().c_str() );
+#if DEBUG
+          std::cout << F( "  [req] " ) << request.getBody() << std::endl;
+#endif
+        }
+
+        if ( connected() ) status = readStatus();
+
+        return status;
+      }
+
+
+      void startRequest()
+      {
+        parser.reset();
+        reusable = false;
+        startDeadline();
+      }
+
+
+      void writeHead( const QString& method, const HttpRequest& request )
+      {
+        startRequest();
+
+        print( method.c_str() );
+        print( " " );
+
+        print( request.getUri().c_str() );
+        println( F( " HTTP/1.1" ) );
+        print( F( "Host: " ) );
+        println( server.c_str() );
+
+        // Signed requests already carry their Content-Length
+        const bool length = request.getBody().size() > 0 &&
+          request.getHeader( HttpRequest::ContentLength ) == NULL;
+        if ( length )
+        {
+          print( F( "Content-Length: " ) );
+          println( request.getBody().size() );
         }
 
 #if DEBUG
         std::cout << F( "  [req] ") << method << F( " " ) <<
           request.getUri() << F( " HTTP/1.1" ) << std::endl;
         std::cout << F( "  [req] Host: " ) << server << std::endl;
-        std::cout << F( "  [req] Content-Length: " ) << request.getBody().size() << std::endl;
+        if ( length ) std::cout << F( "  [req] Content-Length: " ) << request.getBody().size() << std::endl;
 #endif
 
-        writeHeaders( request );
+        writeHeaders( request, ! keepAlive );
 
         const QString& parameters = request.getParamters();
-        if ( parameters.size() > 0 ) C::println( parameters.c_str() );
+        if ( parameters.size() > 0 ) println( parameters.c_str() );
+      }
 
-        if ( request.getBody().size() > 0 )
-        {
-          C::println( request.getBody().c_str() );
-#if DEBUG
-          std::cout << F( "  [req] " ) << request.getBody() << std::endl;
-#endif
-        }
-        C::println();
 
-        if ( connected() )
-        {
-          const QString& line = readLine();
-          if ( line.size() > 14 ) status =  atoi( line.substr( 9, 3 ).c_str() );
-#if DEBUG
-          std::cout << F( "  [resp] " ) << line << std::endl;
-#endif
-        }
+      std::size_t write( const char* data, std::size_t length )
+      {
+        return buffer( data, length );
+      }
 
-        return status;
+
+      int available()
+      {
+        sendBuffer();
+        return ( rxEnd - rxStart ) + C::available();
+      }
+
+
+      int read()
+      {
+        sendBuffer();
+        if ( rxStart < rxEnd ) return static_cast<unsigned char>( rxBuffer[rxStart++] );
+        return C::read();
+      }
+
+
+      int read( char* data, std::size_t length )
+      {
+        sendBuffer();
+        if ( ! fill() ) return 0;
+
+        std::size_t count = rxEnd - rxStart;
+        if ( count > length ) count = length;
+
+        memcpy( data, rxBuffer + rxStart, count );
+        rxStart += count;
+        return count;
+      }
+
+
+      uint16_t readStatus()
+      {
+        sendBuffer();
+        receive( ResponseParser::Headers, NULL );
+        return parser.getStatus();
       }
 
 
@@ -229,96 +509,249 @@ namespace qsense
 
         while ( connected() )
         {
-#if defined( ARDUINO )
-          int c = ' ';
-#else
-          char c = ' ';
-#endif
-
-          if ( C::available() )
+          if ( ! fill() )
           {
-            c = C::read();
-
-            while ( c >= 0 && c != '\n' )
+            if ( expired() )
             {
-              if ( c != '\r' ) line += static_cast<char>( c );
-              c = C::read();
+              abandon( ReceiveTimeout );
+              break;
             }
+            continue;
           }
 
-          if ( c == '\n' ) break;
+          const char* begin = rxBuffer + rxStart;
+          const char* end = static_cast<const char*>(
+            memchr( begin, '\n', rxEnd - rxStart ) );
+          const bool complete = ( end != NULL );
+          if ( ! complete ) end = rxBuffer + rxEnd;
+
+          line.append( begin, end - begin );
+          rxStart = ( end - rxBuffer ) + ( complete ? 1 : 0 );
+
+          if ( complete ) break;
         }
 
+        if ( line.size() > 0 && line[line.size() - 1] == '\r' ) line.resize( line.size() - 1 );
         return line;
       }
 
 
       HttpRequest::Map readHeaders()
       {
-        HttpRequest::Map m;
-
-        while ( connected() )
-        {
-          const QString& line = readLine();
-
-          std::size_t found = line.find( ":" );
-          if ( found != QString::npos )
-          {
-            const QString& key = line.substr( 0, found );
-            const QString& value = line.substr( found + 2 );
-            m.insert( std::pair<QString,QString>( key, value ) );
-          }
-
-          if ( line.size() <= 1 ) break;
-        }
-
-        return m;
+        http::HeaderMap headers;
+        receive( ResponseParser::Body, &headers );
+        return headers.map;
       }
 
 
       const QString readBody()
       {
-        QString content;
+        http::BodyString body;
+        receive( ResponseParser::Complete, &body );
 
-        if ( connected() ) readHeaders();
-        while ( connected() )
-        {
-          const QString& line = readLine();
-          if ( line.size() == 0 ) break;
-          content.append( line );
-        }
-
-        return content;
+        reusable = keepAlive && parser.isComplete() && parser.isKeepAlive();
+        return body.content;
       }
 
 
     protected:
       void writeHeaders( const HttpRequest& request, bool close = true )
       {
-        for ( HttpRequest::Iterator iter = request.beginHeaders();
+        for ( HttpRequest::HeaderIterator iter = request.beginHeaders();
             iter != request.endHeaders(); ++iter )
         {
-          C::print( iter->first.c_str() );
-          C::print( ": " );
-          C::println( iter->second.c_str() );
+          if ( iter->getId() == HttpRequest::CustomHeader ) print( iter->getName() );
+          else print( HttpRequest::getHeaderName( iter->getId() ) );
+          print( ": " );
+          buffer( iter->getValue(), iter->getLength() );
+          println();
 #if DEBUG
-          std::cout << F( "  [req] " ) << iter->first << ": " << iter->second << std::endl;
+          std::cout << F( "  [req] " );
+          if ( iter->getId() == HttpRequest::CustomHeader ) std::cout << iter->getName();
+          else std::cout << HttpRequest::getHeaderName( iter->getId() );
+          std::cout << ": " << iter->getValue() << std::endl;
 #endif
         }
 
         if ( close )
         {
-          C::println( F( "Connection: close" ) );
+          println( F( "Connection: close" ) );
 #if DEBUG
           std::cout << F( "  [req] " ) << F( "Connection: close" ) << std::endl << std::endl;
 #endif
         }
-        C::println();
+        println();
       }
 
 
+    private:
+      /// Start the deadline for connecting or for the next request.
+      void startDeadline()
+      {
+        deadline = millis() + timeout;
+        error = NoError;
+        http::setDeadline( static_cast<C&>( *this ), deadline );
+      }
+
+      bool expired() const { return int32_t( millis() - deadline ) >= 0; }
+
+      /// Give up on the connection or request, closing the connection.
+      void abandon( Error reason )
+      {
+#if DEBUG
+        std::cout << F( "Request to " ) << server << F( " abandoned, error " ) << reason << std::endl;
+#endif
+        error = reason;
+        ++data::errors[reason];
+        stop();
+      }
+
+      /// Append request data to the send buffer, sending the buffer to the
+      /// server each time it is full.  Returns the number of bytes accepted.
+      std::size_t buffer( const char* data, std::size_t length )
+      {
+        std::size_t count = 0;
+
+        while ( count < length )
+        {
+          if ( txLength == QSENSE_SEND_BUFFER_SIZE && ! sendBuffer() ) break;
+
+          std::size_t size = QSENSE_SEND_BUFFER_SIZE - txLength;
+          if ( size > length - count ) size = length - count;
+
+          memcpy( txBuffer + txLength, data + count, size );
+          txLength += size;
+          count += size;
+        }
+
+        return count;
+      }
+
+      /// Send the buffered request data to the server in a single write.
+      bool sendBuffer()
+      {
+        if ( txLength == 0 ) return true;
+
+        const std::size_t sent = C::write( reinterpret_cast<const uint8_t*>( txBuffer ), txLength );
+        const bool complete = ( sent == txLength );
+        txLength = 0;
+
+        if ( ! complete && http::timedOut( static_cast<C&>( *this ) ) ) abandon( SendTimeout );
+        return complete;
+      }
+
+      void print( const char* str ) { buffer( str, strlen( str ) ); }
+
+      void print( const QString& str ) { buffer( str.data(), str.size() ); }
+
+      /// Copy the string from flash straight into the send buffer.
+      void print( const qsense::FlashString& str )
+      {
+        std::size_t position = 0;
+        while ( str.at( position ) != '\0' )
+        {
+          if ( txLength == QSENSE_SEND_BUFFER_SIZE && ! sendBuffer() ) break;
+
+          const std::size_t count = str.copy( txBuffer + txLength,
+            QSENSE_SEND_BUFFER_SIZE - txLength, position );
+          txLength += count;
+          position += count;
+        }
+      }
+
+#if defined( ARDUINO )
+      void print( const __FlashStringHelper* str )
+      {
+        print( qsense::FlashString( reinterpret_cast<const char*>( str ) ) );
+      }
+#endif
+
+      void print( std::size_t number )
+      {
+        // Enough for the 20 digits of a 64 bit size on hosts
+        char digits[20];
+        char* ptr = digits + sizeof( digits );
+        do
+        {
+          *--ptr = static_cast<char>( '0' + number % 10 );
+          number /= 10;
+        }
+        while ( number > 0 );
+
+        buffer( ptr, digits + sizeof( digits ) - ptr );
+      }
+
+      void println() { buffer( "\r\n", 2 ); }
+
+      template <typename T>
+      void println( T value )
+      {
+        print( value );
+        println();
+      }
+
+      /// Parse the response until the parser reaches the specified state,
+      /// reporting the headers and body parsed to the handler.
+      void receive( ResponseParser::State until, ResponseParser::Handler* handler )
+      {
+        parser.setHandler( handler );
+
+        while ( parser.getState() < until )
+        {
+          if ( ! fill() )
+          {
+            if ( ! C::connected() )
+            {
+              parser.finish();
+              break;
+            }
+
+            if ( expired() )
+            {
+              abandon( ReceiveTimeout );
+              break;
+            }
+            continue;
+          }
+
+          rxStart += parser.parse( rxBuffer + rxStart, rxEnd - rxStart );
+        }
+
+        parser.setHandler( NULL );
+      }
+
+      /// Read the response data available from the network into the
+      /// receive buffer in a single transfer, once the buffered data has
+      /// been consumed.  Returns \c false if there is no data to read.
+      bool fill()
+      {
+        if ( rxStart < rxEnd ) return true;
+        rxStart = rxEnd = 0;
+
+        const int count = C::available();
+        if ( count <= 0 ) return false;
+
+        const int size = ( count < QSENSE_RECEIVE_BUFFER_SIZE ) ? count : QSENSE_RECEIVE_BUFFER_SIZE;
+        const int received = C::read( reinterpret_cast<uint8_t*>( rxBuffer ), size );
+        if ( received <= 0 ) return false;
+
+        rxEnd = received;
+        return true;
+      }
+
     private:
       qsense::QString server;
+      ResponseParser parser;
+      uint32_t timeout;
+      uint32_t deadline;
+      Error error;
+      bool keepAlive;
+      bool reusable;
+      char rxBuffer[QSENSE_RECEIVE_BUFFER_SIZE];
+      uint16_t rxStart;
+      uint16_t rxEnd;
+      char txBuffer[QSENSE_SEND_BUFFER_SIZE];
+      uint16_t txLength;
     };
   }
 }
@@ -346,6 +779,12 @@ HttpClient::Ptr HttpClient::create()
 }
 
 
+uint16_t HttpClient::errorCount( Error error )
+{
+  return qsense::net::data::errors[error];
+}
+
+
 void qsense::net::initNetworkType( qsense::net::NetworkType type )
 {
   if ( ! qsense::net::data::networkTypeInitialised )
@@ -26,14 +26,47 @@ limitations under the License.
 #include "AutoPtr.h"
 #include "RefCountedObject.h"
 #include "HttpRequest.h"
+#include "ResponseParser.h"
 #include "../StandardCplusplus/map"
 #else
 #include <AutoPtr.h>
 #include <RefCountedObject.h>
 #include <net/HttpRequest.h>
+#include <net/ResponseParser.h>
 #include <map>
 #endif
 
+#ifndef QSENSE_RECEIVE_BUFFER_SIZE
+// Number of response bytes read from the network in a single transfer
+#if defined( ARDUINO )
+#define QSENSE_RECEIVE_BUFFER_SIZE 64
+#else
+#define QSENSE_RECEIVE_BUFFER_SIZE 1024
+#endif
+#endif
+
+#ifndef QSENSE_REQUEST_TIMEOUT
+// Number of milliseconds within which a connection must be established,
+// and within which a request must be sent and its response read
+#define QSENSE_REQUEST_TIMEOUT 10000
+#endif
+
+#ifndef QSENSE_DNS_TTL
+// Number of milliseconds for which a resolved server address is reused
+// before the host name is looked up again
+#define QSENSE_DNS_TTL 300000
+#endif
+
+#ifndef QSENSE_SEND_BUFFER_SIZE
+// Number of request bytes assembled before they are sent to the network.
+// Up to a TCP maximum segment size, so that each send fills a segment.
+#if defined( ARDUINO )
+#define QSENSE_SEND_BUFFER_SIZE 512
+#else
+#define QSENSE_SEND_BUFFER_SIZE 1460
+#endif
+#endif
+
 namespace qsense
 {
   /**
@@ -80,6 +113,59 @@ namespace qsense
       virtual bool connected() = 0;
 #endif
 
+      /**
+       * @brief Start connecting to the specified server without waiting
+       * for the connection to be established.  Poll {@link #isConnecting}
+       * until it returns \c false, then check {@link #connected}.
+       *
+       * Only the Ethernet Shield V2 library supports connecting in the
+       * background.  Other network libraries fall back to a blocking connect.
+       * @return Returns \c 0 if the connection could not be started.
+       */
+      virtual int16_t beginConnect( const qsense::QString& server, uint16_t port = 80 ) = 0;
+
+      /// Return \c true while a connection started with {@link #beginConnect} is in progress.
+      virtual bool isConnecting() = 0;
+
+      /// Close the connection to the server.
+      virtual void stop() = 0;
+
+      /**
+       * @brief Specify whether HTTP keep-alive is to be used for requests.
+       * When disabled (default) a \c Connection: \c close header is sent
+       * with each request, and the server closes the connection after
+       * responding.
+       */
+      virtual void setKeepAlive( bool flag ) = 0;
+
+      /// Reasons for which a request was abandoned.
+      enum Error { NoError = 0, ConnectTimeout, SendTimeout, ReceiveTimeout };
+
+      /**
+       * @brief Set the number of milliseconds allowed for connecting, and
+       * for sending a request and reading its response (default
+       * \c QSENSE_REQUEST_TIMEOUT).  The deadline bounds every blocking
+       * connect, send and receive.  A connection that misses its deadline
+       * is closed, and the reason is available from {@link #getError}.
+       */
+      virtual void setRequestTimeout( uint32_t milliseconds ) = 0;
+
+      /// Return the reason the last connection or request was abandoned,
+      /// or \c NoError.
+      virtual Error getError() const = 0;
+
+      /// Return the number of connections and requests abandoned with the
+      /// specified error by all clients.
+      static uint16_t errorCount( Error error );
+
+      /**
+       * @brief Check whether the connection may be used for another request.
+       * Returns \c true only if the last response body was read in full
+       * (see {@link #readBody}) based on its \c Content-Length or chunked
+       * framing and the server did not ask for the connection to be closed.
+       */
+      virtual bool isReusable() const = 0;
+
       /**
        * @brief Perform a GET request using information in the request object.
        * @param request The request object that encapsulates the uri and
@@ -105,22 +191,69 @@ namespace qsense
        */
       virtual uint16_t remove( const HttpRequest& request ) = 0;
 
+      /**
+       * @brief Send the request line and headers for the specified request.
+       * The request body is not sent.  Use {@link #write} to send the body
+       * and {@link #available}/{@link #read} to read the response.  This
+       * allows callers to perform a request in steps without blocking.
+       *
+       * @param method The HTTP method for the request (e.g. \c POST)
+       * @param request The request object that encapsulates the uri and
+       *   other relevant information
+       */
+      virtual void writeHead( const qsense::QString& method, const HttpRequest& request ) = 0;
+
+      /**
+       * @brief Prepare to send a request whose head is written directly
+       * with {@link #write}.  Discards the state of the previous response.
+       * Not required when using {@link #writeHead}.
+       */
+      virtual void startRequest() = 0;
+
+      /// Send the specified bytes to the server.  Return the number of bytes sent.
+      virtual std::size_t write( const char* data, std::size_t length ) = 0;
+
+      /// Return the number of response bytes that may be read without blocking.
+      virtual int available() = 0;
+
+      /// Read the next byte of the response.  Returns \c -1 if none is available.
+      virtual int read() = 0;
+
+      /**
+       * @brief Read up to \c length bytes of the response that are available
+       * without blocking.
+       * @return The number of bytes read, \c 0 if none were available.
+       */
+      virtual int read( char* data, std::size_t length ) = 0;
+
+      /**
+       * @brief Read the status line of the response to a request sent
+       * with {@link #writeHead} and {@link #write}.
+       * @return The HTTP response code, or \c 0 if no response was received.
+       */
+      virtual uint16_t readStatus() = 0;
+
       /**
        * @brief Read a line from the HTTP response.
        *
        * A line can be either a header or content.  Use to process raw
-       * HTTP response line by line.
+       * HTTP response line by line.  Bypasses the response parser used by
+       * {@link #readStatus}, {@link #readHeaders} and {@link #readBody}.
        * @return A line (content until newline character) of text from raw response.
        */
       virtual const qsense::QString readLine() = 0;
 
-      /// Return a map of the HTTP response headers
+      /// Return a map of the HTTP response headers.  Reads the status
+      /// line first if {@link #readStatus} has not been called.
       virtual HttpRequest::Map readHeaders() = 0;
 
       /**
        * @brief Read the entire contents of the server response body.
-       * Note: This method also reads headers.  If headers have already
-       * been read, it may end up losing some of the response body.
+       * Note: This method also reads any headers not yet read.  The body
+       * is framed by its \c Content-Length or chunked transfer encoding
+       * (de-chunked content is returned), which leaves a keep-alive
+       * connection ready for the next request.  Otherwise the body is
+       * read until the server closes the connection.
        *
        * WARNING: Use with caution.  Can run embedded devices
        * out of memory very easily.
@@ -29,8 +29,12 @@ limitations under the License.
 
 #else
 #include <cstdint>
+#include <cstring>
 #include <string>
 #define F(x) x
+#define PROGMEM
+#define pgm_read_byte(addr) (*reinterpret_cast<const unsigned char*>(addr))
+#define strlen_P(str) strlen(str)
 #endif
 
 #ifndef DEBUG
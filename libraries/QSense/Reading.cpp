@@ -15,36 +15,226 @@ limitations under the License.
 #include "Reading.h"
 
 #if defined( ARDUINO )
-#include "../StandardCplusplus/sstream"
+#include "FlashString.h"
+#include "JsonWriter.h"
+#include "NumberFormat.h"
 #else
-#include <sstream>
+#include <FlashString.h>
+#include <JsonWriter.h>
+#include <NumberFormat.h>
 #endif
 
+namespace qsense
+{
+  namespace data
+  {
+    /// JSON literals for boolean and missing values
+    const char keywords[] PROGMEM = "truefalsenull";
+
+    /// Number of decimal places configured for a reading key.
+    struct Precision
+    {
+      qsense::Symbol key;
+      int8_t decimals;
+    };
+
+    Precision precisions[QSENSE_READING_PRECISIONS];
+    uint8_t precisionCount = 0;
+
+    Precision* findPrecision( const qsense::Symbol& key )
+    {
+      for ( uint8_t i = 0; i < precisionCount; ++i )
+      {
+        if ( precisions[i].key == key ) return precisions + i;
+      }
+
+      return NULL;
+    }
+  }
+}
+
+using qsense::FlashString;
+using qsense::NumberFormat;
 using qsense::Reading;
 using qsense::QString;
 
 
-Reading::Reading( const QString& k, float v, const QString& ts ) :
-  key( k ), timestamp( ts )
+Reading::Reading( const Reading& reading ) : key( reading.key ),
+  timestamp( reading.timestamp ), number( reading.number ), type( reading.type )
+{
+  if ( type == Text ) number.text = new QString( *reading.number.text );
+}
+
+
+Reading::~Reading()
+{
+  if ( type == Text ) delete number.text;
+}
+
+
+Reading& Reading::operator = ( const Reading& reading )
+{
+  if ( this == &reading ) return *this;
+
+  if ( type == Text ) delete number.text;
+
+  key = reading.key;
+  timestamp = reading.timestamp;
+  number = reading.number;
+  type = reading.type;
+
+  if ( type == Text ) number.text = new QString( *reading.number.text );
+  return *this;
+}
+
+
+float Reading::getFloat() const
+{
+  switch ( type )
+  {
+    case Float: return number.f;
+    case Integer: return float( number.i );
+    case Boolean: return number.b ? 1.0f : 0.0f;
+    default: return 0.0f;
+  }
+}
+
+
+int32_t Reading::getInteger() const
+{
+  switch ( type )
+  {
+    case Float: return int32_t( number.f );
+    case Integer: return number.i;
+    case Boolean: return number.b ? 1 : 0;
+    default: return 0;
+  }
+}
+
+
+bool Reading::getBoolean() const
+{
+  switch ( type )
+  {
+    case Float: return number.f != 0.0f;
+    case Integer: return number.i != 0;
+    case Boolean: return number.b;
+    default: return false;
+  }
+}
+
+
+const QString& Reading::getText() const
 {
-  std::stringstream ss;
-  ss << v;
-  value = ss.str();
+  static const QString empty;
+  return ( type == Text ) ? *number.text : empty;
+}
+
+
+const QString Reading::getValue() const
+{
+  if ( type == Text ) return *number.text;
+
+  char buffer[NumberFormat::bufferSize];
+  const std::size_t length = format( buffer );
+  if ( length > 0 ) return QString( buffer, length );
+  return QString( buffer, FlashString( data::keywords ).copy( buffer, 4, 9 ) );
+}
+
+
+std::size_t Reading::format( char* buffer ) const
+{
+  switch ( type )
+  {
+    case Float:
+      return NumberFormat::format( number.f, getPrecision( key ), buffer );
+
+    case Integer:
+      return NumberFormat::format( number.i, buffer );
+
+    case Boolean:
+      return number.b ? FlashString( data::keywords ).copy( buffer, 4 ) :
+        FlashString( data::keywords ).copy( buffer, 5, 4 );
+
+    default:
+      return 0;
+  }
 }
 
 
 const QString Reading::toString() const
 {
-  std::stringstream ss;
-  ss << *this;
-  return ss.str();
+  QString str;
+  qsense::StringSink sink( str );
+  qsense::JsonWriter writer( sink );
+  writer << *this;
+  writer.flush();
+  return str;
+}
+
+
+bool Reading::setPrecision( const qsense::Symbol& key, int8_t decimals )
+{
+  using qsense::data::Precision;
+  using qsense::data::precisions;
+  using qsense::data::precisionCount;
+
+  if ( ! key.isValid() ) return false;
+  if ( decimals > NumberFormat::maxDecimals ) decimals = NumberFormat::maxDecimals;
+
+  Precision* precision = qsense::data::findPrecision( key );
+  if ( precision != NULL )
+  {
+    if ( decimals >= 0 ) precision->decimals = decimals;
+    else *precision = precisions[--precisionCount];
+    return true;
+  }
+
+  if ( decimals < 0 ) return true;
+  if ( precisionCount >= QSENSE_READING_PRECISIONS ) return false;
+
+  precisions[precisionCount].key = key;
+  precisions[precisionCount++].decimals = decimals;
+  return true;
+}
+
+
+int8_t Reading::getPrecision( const qsense::Symbol& key )
+{
+  const qsense::data::Precision* precision = qsense::data::findPrecision( key );
+  return ( precision == NULL ) ? -1 : precision->decimals;
 }
 
 
 std::ostream& qsense::operator << ( std::ostream& os, const Reading& reading )
 {
-  os << "{\"key\": \"" << reading.getKey() <<
-    "\", \"ts\": \"" << reading.getTimestamp() <<
-    "\", \"value\": \"" << reading.getValue() << "\"}";
+  qsense::StreamSink sink( os );
+  qsense::JsonWriter writer( sink );
+  writer << reading;
   return os;
 }
+
+
+qsense::JsonWriter& qsense::operator << ( JsonWriter& writer, const Reading& reading )
+{
+  using qsense::net::DateTime;
+
+  char buffer[NumberFormat::bufferSize];
+  const std::size_t iso = DateTime::singleton().isoTime( reading.getTimestamp(), buffer );
+
+  writer.raw( F( "{\"key\": " ) ).string( reading.getKey() ).raw( F( ", \"ts\": \"" ) ).
+    raw( buffer, iso ).raw( F( "\", \"value\": " ) );
+
+  if ( reading.getType() == Reading::Text )
+  {
+    writer.string( reading.getText() );
+  }
+  else
+  {
+    const std::size_t length = reading.format( buffer );
+    if ( length == 0 ) writer.raw( F( "null" ) );
+    else writer.raw( buffer, length );
+  }
+
+  return writer.raw( '}' );
+}
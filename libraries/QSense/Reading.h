@@ -18,64 +18,229 @@ limitations under the License.
 #if defined( ARDUINO )
 #include "QSense.h"
 #include "DateTime.h"
+#include "Symbol.h"
 #include "../StandardCplusplus/ostream"
 #else
 #include <QSense.h>
 #include <net/DateTime.h>
+#include <Symbol.h>
 #include <ostream>
 #endif
 
+#ifndef QSENSE_READING_PRECISIONS
+// Maximum number of reading keys for which a precision may be set
+#if defined( ARDUINO )
+#define QSENSE_READING_PRECISIONS 4
+#else
+#define QSENSE_READING_PRECISIONS 16
+#endif
+#endif
+
 namespace qsense
 {
   /**
    * @brief A class that represents a single reading.  Readings are
    * added to an {@link Event}.
+   *
+   * The value is held in its native type (float, integer, boolean or
+   * string) and only converted to text when the event is serialised.
+   * Numbers are written with the fewest digits that preserve the value,
+   * or to the number of decimal places configured for the reading key
+   * with {@link #setPrecision}.  Keys are interned as {@link Symbol}s, so
+   * readings with the same key share a single copy of it.
    */
   class Reading
   {
   public:
+    /// The types of value a reading may hold.
+    enum Type { Text = 0, Float, Integer, Boolean };
+
+    /// Create an empty reading without a key.  For containers of fixed
+    /// capacity such as {@link StaticEvent}.
+    Reading() : timestamp( 0 ), type( Integer ) { number.i = 0; }
+
     /**
      * @brief Create a new reading with specified values.
      * @param k The key to associate with the reading
      * @param v The value of the reading
-     * @param ts The timestamp (optional) at which reading was taken.
+     * @param ts The milli seconds since UNIX epoch (optional) at which the
+     *   reading was taken.
+     */
+    Reading( const qsense::Symbol& k, const qsense::QString& v,
+        int64_t ts = qsense::net::DateTime::singleton().currentTimeMillis() ) :
+      key( k ), timestamp( ts ), type( Text ) { number.text = new qsense::QString( v ); }
+
+    /**
+     * @brief Create a new reading with a string literal value.
+     * @param k The key to associate with the reading
+     * @param v The value of the reading
+     * @param ts The milli seconds since UNIX epoch (optional) at which the
+     *   reading was taken.
      */
-    Reading( const qsense::QString& k, const qsense::QString& v,
-        const qsense::QString& ts = qsense::net::DateTime::singleton().currentTime() ) :
-      key( k ), value( v ), timestamp( ts ) {}
+    Reading( const qsense::Symbol& k, const char* v,
+        int64_t ts = qsense::net::DateTime::singleton().currentTimeMillis() ) :
+      key( k ), timestamp( ts ), type( Text ) { number.text = new qsense::QString( v ); }
 
     /**
      * @brief Create a new reading with specified values.
      * @param k The key to associate with the reading
      * @param v The float value of the reading
-     * @param ts The timestamp (optional) at which reading was taken.
+     * @param ts The milli seconds since UNIX epoch (optional) at which the
+     *   reading was taken.
      */
-    Reading( const qsense::QString& k, float v,
-        const qsense::QString& ts = qsense::net::DateTime::singleton().currentTime() );
+    Reading( const qsense::Symbol& k, float v,
+        int64_t ts = qsense::net::DateTime::singleton().currentTimeMillis() ) :
+      key( k ), timestamp( ts ), type( Float ) { number.f = v; }
+
+    /// Create a new reading with a \c double value, which is held as a
+    /// \c float.
+    Reading( const qsense::Symbol& k, double v,
+        int64_t ts = qsense::net::DateTime::singleton().currentTimeMillis() ) :
+      key( k ), timestamp( ts ), type( Float ) { number.f = float( v ); }
+
+    /// Create a new reading with an integer value.
+    Reading( const qsense::Symbol& k, int v,
+        int64_t ts = qsense::net::DateTime::singleton().currentTimeMillis() ) :
+      key( k ), timestamp( ts ), type( Integer ) { number.i = v; }
+
+    /// Create a new reading with a \c long integer value.  Integers are
+    /// held in 32 bits, and values beyond that range as floats.
+    Reading( const qsense::Symbol& k, long v,
+        int64_t ts = qsense::net::DateTime::singleton().currentTimeMillis() ) :
+      key( k ), timestamp( ts ), type( Integer ) { setInteger( v ); }
+
+    /// Create a new reading with an \c unsigned integer value.
+    Reading( const qsense::Symbol& k, unsigned int v,
+        int64_t ts = qsense::net::DateTime::singleton().currentTimeMillis() ) :
+      key( k ), timestamp( ts ), type( Integer ) { setInteger( v ); }
+
+    /// Create a new reading with an \c unsigned \c long value, such as
+    /// returned by \c millis().
+    Reading( const qsense::Symbol& k, unsigned long v,
+        int64_t ts = qsense::net::DateTime::singleton().currentTimeMillis() ) :
+      key( k ), timestamp( ts ), type( Integer ) { setInteger( v ); }
+
+    /// Create a new reading with a \c long \c long value.
+    Reading( const qsense::Symbol& k, long long v,
+        int64_t ts = qsense::net::DateTime::singleton().currentTimeMillis() ) :
+      key( k ), timestamp( ts ), type( Integer ) { setInteger( v ); }
+
+    /// Create a new reading with an \c unsigned \c long \c long value.
+    Reading( const qsense::Symbol& k, unsigned long long v,
+        int64_t ts = qsense::net::DateTime::singleton().currentTimeMillis() ) :
+      key( k ), timestamp( ts ), type( Integer ) { setInteger( v ); }
+
+    /// Create a new reading with a boolean value.
+    Reading( const qsense::Symbol& k, bool v,
+        int64_t ts = qsense::net::DateTime::singleton().currentTimeMillis() ) :
+      key( k ), timestamp( ts ), type( Boolean ) { number.b = v; }
 
-    /// Destructor.  No actions required.
-    ~Reading() {}
+    /// Copy constructor.  Copies the string value, if any.
+    Reading( const Reading& reading );
+
+    /// Destructor.  Releases the string value, if any.
+    ~Reading();
+
+    /// Assignment operator.  Copies the string value, if any.
+    Reading& operator = ( const Reading& reading );
 
     /// Return the key for the reading
-    const qsense::QString& getKey() const { return key; }
+    const qsense::QString& getKey() const { return key.str(); }
+
+    /// Return the interned key for the reading
+    const qsense::Symbol& getKeySymbol() const { return key; }
+
+    /// Return the type of value held.
+    Type getType() const { return Type( type ); }
+
+    /// Return the float value.  Integer and boolean values are converted.
+    float getFloat() const;
 
-    /// Return the value of the reading.
-    const qsense::QString& getValue() const { return value; }
+    /// Return the integer value.  Float values are truncated, boolean
+    /// values converted.
+    int32_t getInteger() const;
 
-    /// Return the time at which the reading was taken.
-    const qsense::QString& getTimestamp() const { return timestamp; }
+    /// Return the boolean value.  Numbers other than zero are \c true.
+    bool getBoolean() const;
+
+    /// Return the string value.  Empty for other types.
+    const qsense::QString& getText() const;
+
+    /// Return the value of the reading as text, formatted as it is
+    /// serialised.  Not finite float values are returned as \c null.
+    const qsense::QString getValue() const;
+
+    /**
+     * @brief Format a number or boolean value as JSON.
+     * @param buffer The buffer of at least \c NumberFormat::bufferSize
+     *   bytes to write to.  The text is not null terminated.
+     * @return The number of characters written.  \c 0 for string values,
+     *   or float values that are not finite.
+     */
+    std::size_t format( char* buffer ) const;
+
+    /// Return the milli seconds since UNIX epoch at which the reading was
+    /// taken.
+    int64_t getTimestamp() const { return timestamp; }
 
     /// Return a JSON representation of the reading
     const qsense::QString toString() const;
 
+    /**
+     * @brief Set the number of decimal places to which float values of
+     * readings with the specified key are written.  Applies to readings
+     * serialised from now on, including those already created.
+     * @param key The reading key.
+     * @param decimals The number of decimal places, up to
+     *   \c NumberFormat::maxDecimals.  Negative to restore the default
+     *   shortest form.
+     * @return Returns \c false if \c QSENSE_READING_PRECISIONS keys already
+     *   have a precision set, or the key could not be interned.
+     */
+    static bool setPrecision( const qsense::Symbol& key, int8_t decimals );
+
+    /// Return the number of decimal places set for the key, or \c -1 if
+    /// none.
+    static int8_t getPrecision( const qsense::Symbol& key );
+
   private:
-    qsense::QString key;
-    qsense::QString value;
-    qsense::QString timestamp;
+    // Integers beyond 32 bits are held as floats rather than wrapped
+    template <typename T>
+    void setInteger( T v )
+    {
+      if ( v == T( int32_t( v ) ) && ( v < 0 ) == ( int32_t( v ) < 0 ) ) number.i = int32_t( v );
+      else
+      {
+        type = Float;
+        number.f = float( v );
+      }
+    }
+
+    // Only string values are held on the heap, so that numeric readings
+    // may be copied and discarded without allocating
+    union Number
+    {
+      float f;
+      int32_t i;
+      bool b;
+      qsense::QString* text;
+    };
+
+    qsense::Symbol key;
+    int64_t timestamp;
+    Number number;
+    uint8_t type;
   };
 
-  /// Serialise the reading as JSON to the output stream.
+  class JsonWriter;
+
+  /// Serialise the reading as JSON to the output stream.  The timestamp
+  /// is formatted as ISO 8601 only now.
   std::ostream& operator << ( std::ostream& os, const qsense::Reading& reading );
+
+  /// Serialise the reading as JSON to the writer.  The key and string
+  /// value are escaped.
+  JsonWriter& operator << ( JsonWriter& writer, const qsense::Reading& reading );
 }
 
 #endif // QSENSE_READING_H
@@ -0,0 +1,170 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "ReadingFilter.h"
+
+namespace qsense
+{
+  namespace data
+  {
+    /// Return \c true if the value moved outside the deadband around the
+    /// last value.  A change to or from NaN is always a change.
+    bool changed( float last, float value, float absolute, float relative )
+    {
+      if ( value != value || last != last ) return ( value == value ) != ( last == last );
+
+      const float difference = ( value > last ) ? value - last : last - value;
+      const float magnitude = ( last < 0 ) ? -last : last;
+      const float band = ( relative * magnitude > absolute ) ? relative * magnitude : absolute;
+      return difference > band;
+    }
+  }
+}
+
+using qsense::Reading;
+using qsense::ReadingFilter;
+using qsense::Symbol;
+
+
+ReadingFilter::ReadingFilter() :
+  keys(), settings(), defaultSettings(), total( 0 ), filtering( false ) {}
+
+
+void ReadingFilter::setDefault( const Settings& s )
+{
+  defaultSettings = s;
+  filtering = true;
+}
+
+
+bool ReadingFilter::configure( const Symbol& key, const Settings& s )
+{
+  if ( ! key.isValid() ) return false;
+
+  Key* entry = find( key );
+  if ( entry != NULL && entry->settings != defaults )
+  {
+    settings[entry->settings] = s;
+    return true;
+  }
+
+  if ( settings.size() >= QSENSE_FILTER_KEYS || settings.size() >= defaults ) return false;
+  if ( entry == NULL ) entry = create( key, defaults );
+  if ( entry == NULL ) return false;
+
+  entry->settings = uint8_t( settings.size() );
+  settings.push_back( s );
+  return true;
+}
+
+
+bool ReadingFilter::test( const Reading& reading )
+{
+  if ( reading.getType() == Reading::Text ) return true;
+
+  Key* entry = find( reading.getKeySymbol() );
+  if ( entry == NULL || entry->settings == defaults )
+  {
+    // Keys without settings of their own pass until defaults are set
+    if ( ! filtering ) return true;
+    if ( entry == NULL ) entry = create( reading.getKeySymbol(), defaults );
+    if ( entry == NULL ) return true;
+  }
+
+  const Settings& s = ( entry->settings == defaults ) ?
+    defaultSettings : settings[entry->settings];
+  const float value = reading.getFloat();
+  const int64_t elapsed = reading.getTimestamp() - entry->timestamp;
+
+  bool pass = true;
+  if ( entry->seen )
+  {
+    if ( s.heartbeat > 0 && elapsed >= int64_t( s.heartbeat ) ) pass = true;
+    else if ( elapsed < int64_t( s.minimumInterval ) ) pass = false;
+    else pass = data::changed( entry->value, value, s.absolute, s.relative );
+  }
+
+  if ( ! pass )
+  {
+    ++entry->suppressed;
+    ++total;
+  }
+
+  return pass;
+}
+
+
+void ReadingFilter::commit( const Reading& reading )
+{
+  if ( reading.getType() == Reading::Text ) return;
+
+  // Keys are added to the filter by test, the others are not filtered
+  Key* entry = find( reading.getKeySymbol() );
+  if ( entry == NULL ) return;
+
+  entry->timestamp = reading.getTimestamp();
+  entry->value = reading.getFloat();
+  entry->seen = true;
+}
+
+
+uint32_t ReadingFilter::suppressed( const Symbol& key ) const
+{
+  for ( std::size_t i = 0; i < keys.size(); ++i )
+  {
+    if ( keys[i].key == key ) return keys[i].suppressed;
+  }
+
+  return 0;
+}
+
+
+void ReadingFilter::reset()
+{
+  for ( std::size_t i = 0; i < keys.size(); ++i )
+  {
+    keys[i].suppressed = 0;
+    keys[i].seen = false;
+  }
+
+  total = 0;
+}
+
+
+ReadingFilter::Key* ReadingFilter::find( const Symbol& key )
+{
+  for ( std::size_t i = 0; i < keys.size(); ++i )
+  {
+    if ( keys[i].key == key ) return &keys[i];
+  }
+
+  return NULL;
+}
+
+
+ReadingFilter::Key* ReadingFilter::create( const Symbol& key, uint8_t s )
+{
+  if ( keys.size() >= QSENSE_FILTER_KEYS || ! key.isValid() ) return NULL;
+
+  Key entry;
+  entry.key = key;
+  entry.timestamp = 0;
+  entry.suppressed = 0;
+  entry.value = 0;
+  entry.settings = s;
+  entry.seen = false;
+
+  keys.push_back( entry );
+  return &keys.back();
+}
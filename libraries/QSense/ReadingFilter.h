@@ -0,0 +1,186 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef QSENSE_READINGFILTER_H
+#define QSENSE_READINGFILTER_H
+
+#if defined( ARDUINO )
+#include "QSense.h"
+#include "Reading.h"
+#include "Symbol.h"
+#include "../StandardCplusplus/vector"
+#else
+#include <QSense.h>
+#include <Reading.h>
+#include <Symbol.h>
+#include <vector>
+#endif
+
+#ifndef QSENSE_FILTER_KEYS
+// Maximum number of reading keys filtered
+#if defined( ARDUINO )
+#define QSENSE_FILTER_KEYS 8
+#else
+#define QSENSE_FILTER_KEYS 256
+#endif
+#endif
+
+namespace qsense
+{
+  /**
+   * @brief Suppresses readings that do not differ enough from the last
+   * reading of the same key to be worth publishing.
+   *
+   * A reading passes the filter if its value moved outside the deadband
+   * around the last value that passed, no sooner than the minimum
+   * interval after it.  A reading always passes once the heartbeat
+   * interval has elapsed without one, so that a steady sensor is still
+   * seen to be alive.  The deadband is the larger of the absolute band and
+   * the relative band times the last value.  String readings, and readings
+   * of keys beyond the first \c QSENSE_FILTER_KEYS, always pass.
+   *
+   * The filter passes every reading of a key until settings are given,
+   * for all keys with {@link #setDefault} or for the key with
+   * {@link #configure}:
+   *
+   * \code
+   * ReadingFilter filter;
+   * filter.setDefault( ReadingFilter::Settings( 0.5f, 0, 1000, 3600000 ) );
+   * const Reading reading( "temperature", sensor.read() );
+   * if ( filter.accept( reading ) ) event += reading;
+   * \endcode
+   *
+   * Where the reading may yet be dropped, such as from a full event,
+   * {@link #test} it first and {@link #commit} it once it is stored, so
+   * that a reading that was never published does not become the
+   * reference:
+   *
+   * \code
+   * if ( filter.test( reading ) )
+   * {
+   *   const std::size_t count = event.numberOfReadings();
+   *   event += reading;
+   *   if ( event.numberOfReadings() > count ) filter.commit( reading );
+   * }
+   * \endcode
+   */
+  class ReadingFilter
+  {
+  public:
+    /// The conditions under which a reading of a key passes the filter.
+    struct Settings
+    {
+      /**
+       * @brief Create new settings.  The defaults pass any change.
+       * @param absolute The band within which values are unchanged.
+       * @param relative The band within which values are unchanged, as a
+       *   fraction of the last value passed.
+       * @param minimumInterval The milli seconds after a reading passed
+       *   before another may pass.
+       * @param heartbeat The milli seconds after a reading passed after
+       *   which another passes whatever its value, or \c 0 for none.
+       */
+      Settings( float absolute = 0, float relative = 0,
+          uint32_t minimumInterval = 0, uint32_t heartbeat = 0 ) :
+        absolute( absolute ), relative( relative ),
+        minimumInterval( minimumInterval ), heartbeat( heartbeat ) {}
+
+      float absolute;
+      float relative;
+      uint32_t minimumInterval;
+      uint32_t heartbeat;
+    };
+
+    /// Create a filter that passes every reading until configured.
+    ReadingFilter();
+
+    /// Destructor.  No actions required.
+    ~ReadingFilter() {}
+
+    /// Filter the readings of all keys not configured with
+    /// {@link #configure} with the specified settings.
+    void setDefault( const Settings& settings );
+
+    /**
+     * @brief Filter the readings of the specified key with the specified
+     * settings, in place of the defaults.
+     * @return Returns \c false if \c QSENSE_FILTER_KEYS keys are filtered
+     *   already, or the key is not valid.
+     */
+    bool configure( const Symbol& key, const Settings& settings );
+
+    /**
+     * @brief Decide whether the reading is to be published, and make it
+     * the reference for the following readings of the key if it passes.
+     * The same as {@link #test} followed by {@link #commit}.
+     * @return Returns \c true if the reading passes, \c false if it is
+     *   suppressed.
+     */
+    bool accept( const Reading& reading )
+    {
+      if ( ! test( reading ) ) return false;
+      commit( reading );
+      return true;
+    }
+
+    /**
+     * @brief Decide whether the reading is to be published, without
+     * making it the reference.  Suppressed readings are counted.
+     * @return Returns \c true if the reading passes, \c false if it is
+     *   suppressed.
+     */
+    bool test( const Reading& reading );
+
+    /// Make the reading the reference for the following readings of its
+    /// key.  Call once a reading that passed {@link #test} is stored.
+    void commit( const Reading& reading );
+
+    /// Return the number of readings of all keys suppressed.
+    uint32_t suppressed() const { return total; }
+
+    /// Return the number of readings of the specified key suppressed.
+    uint32_t suppressed( const Symbol& key ) const;
+
+    /// Forget the last readings passed and the numbers suppressed.  The
+    /// settings are retained.
+    void reset();
+
+  private:
+    /// The settings and the last reading passed of one key.
+    struct Key
+    {
+      Symbol key;
+      int64_t timestamp;
+      uint32_t suppressed;
+      float value;
+      uint8_t settings;
+      bool seen;
+    };
+
+    static const uint8_t defaults = 0xFF;
+
+    Key* find( const Symbol& key );
+    Key* create( const Symbol& key, uint8_t settings );
+
+  private:
+    std::vector<Key> keys;
+    std::vector<Settings> settings;
+    Settings defaultSettings;
+    uint32_t total;
+    bool filtering;
+  };
+
+} // namespace qsense
+
+#endif // QSENSE_READINGFILTER_H
@@ -0,0 +1,92 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "RequestTemplate.h"
+
+#if defined( ARDUINO )
+#include <avr/pgmspace.h>
+#include <string.h>
+#else
+#include <cstring>
+#endif
+
+using qsense::QString;
+using qsense::net::RequestTemplate;
+
+
+RequestTemplate::Values::Values()
+{
+  for ( uint8_t i = 0; i <= Signature; ++i )
+  {
+    data[i] = NULL;
+    length[i] = 0;
+  }
+}
+
+
+void RequestTemplate::Values::set( Slot slot, const QString& value )
+{
+  data[slot] = value.data();
+  length[slot] = value.size();
+}
+
+
+void RequestTemplate::Values::set( Slot slot, const char* value )
+{
+  data[slot] = value;
+  length[slot] = strlen( value );
+}
+
+
+void RequestTemplate::Values::set( Slot slot, uint32_t number )
+{
+  // Format from the end of the buffer, no stream required
+  char* ptr = digits + sizeof( digits );
+  do
+  {
+    *--ptr = static_cast<char>( '0' + number % 10 );
+    number /= 10;
+  }
+  while ( number > 0 );
+
+  data[slot] = ptr;
+  length[slot] = digits + sizeof( digits ) - ptr;
+}
+
+
+void RequestTemplate::render( qsense::Sink& sink, const Values& values ) const
+{
+  qsense::SinkBuffer out( sink );
+
+  for ( const char* ptr = head; ; ++ptr )
+  {
+    const uint8_t c = pgm_read_byte( ptr );
+    if ( c == 0 ) break;
+
+    if ( c >= Host && c <= Signature )
+    {
+      if ( values.length[c] > 0 ) out.sputn( values.data[c], values.length[c] );
+    }
+    else if ( c == Uri )
+    {
+      for ( const char* u = uri; pgm_read_byte( u ) != 0; ++u )
+      {
+        out.sputc( static_cast<char>( pgm_read_byte( u ) ) );
+      }
+    }
+    else out.sputc( static_cast<char>( c ) );
+  }
+
+  out.pubsync();
+}
@@ -0,0 +1,114 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef QSENSE_NET_REQUESTTEMPLATE_H
+#define QSENSE_NET_REQUESTTEMPLATE_H
+
+#if defined( ARDUINO )
+#include "QSense.h"
+#include "FlashString.h"
+#include "Sink.h"
+#else
+#include <QSense.h>
+#include <FlashString.h>
+#include <Sink.h>
+#endif
+
+namespace qsense
+{
+  namespace net
+  {
+    /**
+     * @brief A pre-rendered HTTP request head (request line and headers)
+     * for requests that are sent repeatedly to the same endpoint.
+     *
+     * The head is a constant string, which on Arduino is stored in flash
+     * (\c PROGMEM).  Header values that change with each request are
+     * marked with {@link Slot} bytes (\c "\1" to \c "\7") in the string,
+     * and substituted from {@link Values} when the head is rendered.  The
+     * {@link Uri} marker (\c "\10") is replaced by the uri of the template,
+     * for a request line whose uri is only known at run time.  No header
+     * maps or formatted strings are built for a request:
+     *
+     * \code
+     * static const char head[] PROGMEM =
+     *   "POST /rest/v1/event HTTP/1.1\r\n"
+     *   "Host: " "\1" "\r\n"
+     *   "Content-Length: " "\5" "\r\n"
+     *   "\r\n";
+     * \endcode
+     */
+    class RequestTemplate
+    {
+    public:
+      /// Markers for the values substituted when the head is rendered.
+      enum Slot
+      {
+        Host = 1, ContentType = 2, Date = 3, ContentMD5 = 4,
+        ContentLength = 5, AccessKey = 6, Signature = 7,
+        /// The uri given to the template, not set through {@link Values}.
+        Uri = 8
+      };
+
+      /// The values for the slots in a template.  Values are referenced,
+      /// not copied, and must remain valid until the head is rendered.
+      class Values
+      {
+      public:
+        /// Create a new instance with all slots empty.
+        Values();
+
+        /// Set the value for the specified slot.
+        void set( Slot slot, const qsense::QString& value );
+
+        /// Set the value for the specified slot.
+        void set( Slot slot, const char* value );
+
+        /// Set the value for the specified slot to the decimal representation of the number.
+        void set( Slot slot, uint32_t number );
+
+      private:
+        friend class RequestTemplate;
+
+        const char* data[Signature + 1];
+        std::size_t length[Signature + 1];
+        char digits[11];
+      };
+
+      /**
+       * @brief Create a new template.
+       * @param head The request head with slot markers.  On Arduino this
+       *   must be stored in flash using \c PROGMEM.
+       * @param uri The request uri, used when signing the request.  Must
+       *   match the uri in the request line, and be stored in flash as
+       *   for the head.
+       */
+      RequestTemplate( const char* head, const char* uri ) :
+        head( head ), uri( uri ) {}
+
+      /// Return the uri to which the request is sent.
+      qsense::FlashString getUri() const { return qsense::FlashString( uri ); }
+
+      /// Write the request head with the slots filled in to the sink.
+      void render( Sink& sink, const Values& values ) const;
+
+    private:
+      const char* head;
+      const char* uri;
+    };
+
+  } // namespace net
+} // namespace qsense
+
+#endif // QSENSE_NET_REQUESTTEMPLATE_H
@@ -0,0 +1,252 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "ResponseParser.h"
+
+#if defined( ARDUINO )
+#include "../StandardCplusplus/cctype"
+#include "../StandardCplusplus/cstdlib"
+#include "../StandardCplusplus/cstring"
+#else
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#endif
+
+namespace qsense
+{
+  namespace net
+  {
+    namespace data
+    {
+      /// Case insensitive comparison of the end of a header value.
+      bool endsWith( const char* value, const char* expected )
+      {
+        const std::size_t length = strlen( value );
+        const std::size_t size = strlen( expected );
+        if ( length < size ) return false;
+
+        value += length - size;
+        for ( std::size_t i = 0; i < size; ++i )
+        {
+          if ( tolower( value[i] ) != tolower( expected[i] ) ) return false;
+        }
+
+        return true;
+      }
+
+      bool equals( const char* value, const char* expected )
+      {
+        return strlen( value ) == strlen( expected ) && endsWith( value, expected );
+      }
+    }
+  }
+}
+
+using qsense::net::ResponseParser;
+
+
+ResponseParser::ResponseParser( Handler* h ) : handler( h )
+{
+  reset();
+}
+
+
+void ResponseParser::reset()
+{
+  lineLength = 0;
+  contentLength = -1;
+  remaining = 0;
+  status = 0;
+  state = StatusLine;
+  chunked = false;
+  keepAlive = false;
+  noBody = false;
+}
+
+
+std::size_t ResponseParser::parse( const char* data, std::size_t length )
+{
+  std::size_t used = 0;
+
+  while ( used < length && state != Complete && state != Error )
+  {
+    if ( state == Body || state == ChunkData )
+    {
+      // Body data is passed on without copying
+      std::size_t count = length - used;
+      if ( remaining >= 0 && count > std::size_t( remaining ) ) count = remaining;
+
+      if ( handler != NULL ) handler->body( data + used, count );
+      used += count;
+
+      if ( remaining < 0 ) continue;
+      remaining -= count;
+      if ( remaining == 0 ) state = ( state == Body ) ? Complete : ChunkEnd;
+      continue;
+    }
+
+    const char c = data[used++];
+    if ( c == '\n' )
+    {
+      line[lineLength] = '\0';
+      const bool pause = processLine();
+      lineLength = 0;
+      if ( pause ) break;
+    }
+    else if ( c != '\r' && lineLength < maxLine - 1 ) line[lineLength++] = c;
+  }
+
+  return used;
+}
+
+
+void ResponseParser::finish()
+{
+  if ( state == Body && remaining < 0 ) state = Complete;
+  else if ( state != Complete ) state = Error;
+}
+
+
+bool ResponseParser::processLine()
+{
+  switch ( state )
+  {
+    case StatusLine:
+      return processStatus();
+
+    case Headers:
+    case Trailers:
+      return processHeader();
+
+    case ChunkSize:
+    {
+      // Chunk extensions after the size are ignored
+      char* end = NULL;
+      remaining = strtol( line, &end, 16 );
+      if ( end == line || remaining < 0 ) state = Error;
+      else state = ( remaining == 0 ) ? Trailers : ChunkData;
+      return false;
+    }
+
+    case Interim:
+      if ( lineLength == 0 ) state = StatusLine;
+      return false;
+
+    case ChunkEnd:
+      state = ( lineLength == 0 ) ? ChunkSize : Error;
+      return false;
+
+    default:
+      return false;
+  }
+}
+
+
+bool ResponseParser::processStatus()
+{
+  // Tolerate blank lines before the status line
+  if ( lineLength == 0 ) return false;
+
+  if ( lineLength < 12 || strncmp( line, "HTTP/1.", 7 ) != 0 )
+  {
+    state = Error;
+    return true;
+  }
+
+  // Persistent connections are the default from HTTP/1.1
+  keepAlive = ( line[7] != '0' );
+
+  // Interim responses are skipped through to the final response, so that
+  // callers waiting for the status line only see the final status
+  const int code = atoi( line + 9 );
+  if ( code >= 100 && code < 200 )
+  {
+    state = Interim;
+    return false;
+  }
+
+  status = code;
+  state = Headers;
+
+#if DEBUG
+  std::cout << F( "  [resp] " ) << line << std::endl;
+#endif
+
+  if ( handler != NULL ) handler->status( status );
+  return true;
+}
+
+
+bool ResponseParser::processHeader()
+{
+  if ( lineLength == 0 )
+  {
+    if ( state == Trailers ) state = Complete;
+    else endHeaders();
+    return true;
+  }
+
+  char* value = strchr( line, ':' );
+  if ( value == NULL ) return false;
+
+  *value++ = '\0';
+  while ( *value == ' ' || *value == '\t' ) ++value;
+
+  if ( state == Headers )
+  {
+    if ( data::equals( line, "Content-Length" ) )
+    {
+      contentLength = atol( value );
+    }
+    else if ( data::equals( line, "Transfer-Encoding" ) )
+    {
+      chunked = data::endsWith( value, "chunked" );
+    }
+    else if ( data::equals( line, "Connection" ) )
+    {
+      if ( data::equals( value, "close" ) ) keepAlive = false;
+      else if ( data::equals( value, "keep-alive" ) ) keepAlive = true;
+    }
+  }
+
+  if ( handler != NULL ) handler->header( line, value );
+  return false;
+}
+
+
+void ResponseParser::endHeaders()
+{
+  if ( noBody || status == 204 || status == 304 )
+  {
+    state = Complete;
+  }
+  else if ( chunked )
+  {
+    state = ChunkSize;
+  }
+  else if ( contentLength >= 0 )
+  {
+    remaining = contentLength;
+    state = ( remaining == 0 ) ? Complete : Body;
+  }
+  else
+  {
+    // The body is terminated by the server closing the connection
+    remaining = -1;
+    keepAlive = false;
+    state = Body;
+  }
+}
@@ -0,0 +1,155 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef QSENSE_NET_RESPONSEPARSER_H
+#define QSENSE_NET_RESPONSEPARSER_H
+
+#if defined( ARDUINO )
+#include "QSense.h"
+#else
+#include <QSense.h>
+#endif
+
+namespace qsense
+{
+  namespace net
+  {
+    /**
+     * @brief An incremental parser for HTTP/1.1 responses.
+     *
+     * Response data is pushed to the parser in fragments of any size as
+     * it is received.  The status, headers and body are reported to a
+     * {@link Handler} as they are parsed, and nothing is retained apart
+     * from the current line (truncated to \c maxLine bytes) and the few
+     * values needed to frame the body.  Bodies delimited by
+     * \c Content-Length, by chunked transfer encoding or by the server
+     * closing the connection are supported.
+     *
+     * {@link #parse} stops after the status line and after the header
+     * block, so that a caller may read the status without consuming the
+     * body.  Interim (1xx) responses are skipped, and only the status and
+     * headers of the final response are reported:
+     *
+     * \code
+     * std::size_t used = 0;
+     * while ( used < length && ! parser.isComplete() && ! parser.hasError() )
+     * {
+     *   used += parser.parse( data + used, length - used );
+     * }
+     * \endcode
+     */
+    class ResponseParser
+    {
+    public:
+      /// Receives the parts of a response as they are parsed.  The data
+      /// passed is only valid for the duration of the call.
+      class Handler
+      {
+      public:
+        /// Destructor for sub-classes
+        virtual ~Handler() {}
+
+        /// The status line was parsed.
+        virtual void status( uint16_t ) {}
+
+        /// A header (or chunked trailer) was parsed.
+        virtual void header( const char*, const char* ) {}
+
+        /// The next fragment of the (de-chunked) response body was parsed.
+        virtual void body( const char*, std::size_t ) {}
+      };
+
+      /// The parts of the response, in the order in which they are parsed.
+      enum State
+      {
+        StatusLine = 0, Interim, Headers, Body, ChunkSize, ChunkData,
+        ChunkEnd, Trailers, Complete, Error
+      };
+
+      /// Maximum number of bytes of a status or header line retained.
+      static const std::size_t maxLine = 64;
+
+      /// Create a new parser that reports to the specified handler.
+      ResponseParser( Handler* handler = NULL );
+
+      /// Prepare to parse a new response.  The handler is retained.
+      void reset();
+
+      /// Set the handler to which the rest of the response is reported.
+      void setHandler( Handler* h ) { handler = h; }
+
+      /// Do not expect a body, as for the response to a \c HEAD request.
+      void skipBody() { noBody = true; }
+
+      /**
+       * @brief Parse the next fragment of the response.
+       * @param data The bytes received.
+       * @param length The number of bytes received.
+       * @return The number of bytes consumed.  Less than \c length if
+       *   the status line or headers were completed, or the response
+       *   ended.
+       */
+      std::size_t parse( const char* data, std::size_t length );
+
+      /// The server closed the connection.  Completes a body delimited
+      /// by the close, any other incomplete response is an error.
+      void finish();
+
+      /// Return the current state.
+      State getState() const { return state; }
+
+      /// Return the status code, or \c 0 if the status line was not parsed.
+      uint16_t getStatus() const { return status; }
+
+      /// Return the \c Content-Length of the response, or \c -1 if none.
+      int32_t getContentLength() const { return contentLength; }
+
+      /// Return \c true if the response body is chunked.
+      bool isChunked() const { return chunked; }
+
+      /// Return \c true if the server will keep the connection open.
+      bool isKeepAlive() const { return keepAlive; }
+
+      /// Return \c true if the status line and headers were parsed.
+      bool headersComplete() const { return state >= Body && state != Error; }
+
+      /// Return \c true if the entire response was parsed.
+      bool isComplete() const { return state == Complete; }
+
+      /// Return \c true if the response is malformed or was cut short.
+      bool hasError() const { return state == Error; }
+
+    private:
+      bool processLine();
+      bool processStatus();
+      bool processHeader();
+      void endHeaders();
+
+    private:
+      Handler* handler;
+      char line[maxLine];
+      std::size_t lineLength;
+      int32_t contentLength;
+      int32_t remaining;
+      uint16_t status;
+      State state;
+      bool chunked;
+      bool keepAlive;
+      bool noBody;
+    };
+
+  } // namespace net
+} // namespace qsense
+
+#endif // QSENSE_NET_RESPONSEPARSER_H
@@ -0,0 +1,292 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "SeriesBatch.h"
+
+#if defined( ARDUINO )
+#include "Event.h"
+#include "../StandardCplusplus/cstring"
+#else
+#include <Event.h>
+#include <cstring>
+#endif
+
+namespace qsense
+{
+  namespace series
+  {
+    /// Worst case growth of an existing series for one reading, with
+    /// allowance for the length prefix growing
+    static const std::size_t maxPointBytes = 12;
+
+    /// Fixed size of a new series, apart from its key
+    static const std::size_t seriesBytes = 12 + 3 * 3;
+
+    std::size_t varintSize( uint32_t value )
+    {
+      std::size_t size = 1;
+      while ( value >= 0x80 )
+      {
+        value >>= 7;
+        ++size;
+      }
+
+      return size;
+    }
+
+    void varint( std::streambuf& out, uint32_t value )
+    {
+      while ( value >= 0x80 )
+      {
+        out.sputc( static_cast<char>( ( value & 0x7F ) | 0x80 ) );
+        value >>= 7;
+      }
+
+      out.sputc( static_cast<char>( value ) );
+    }
+
+    void text( std::streambuf& out, const qsense::QString& value )
+    {
+      varint( out, value.size() );
+      out.sputn( value.data(), value.size() );
+    }
+
+    void number( std::streambuf& out, float value )
+    {
+      uint32_t bits;
+      memcpy( &bits, &value, sizeof( bits ) );
+      for ( int8_t shift = 24; shift >= 0; shift -= 8 )
+      {
+        out.sputc( static_cast<char>( bits >> shift ) );
+      }
+    }
+
+    uint8_t leadingZeros( uint32_t value )
+    {
+      uint8_t count = 0;
+      for ( uint32_t mask = 0x80000000UL; mask != 0 && ( value & mask ) == 0; mask >>= 1 ) ++count;
+      return count;
+    }
+
+    uint8_t trailingZeros( uint32_t value )
+    {
+      uint8_t count = 0;
+      for ( uint32_t mask = 1; mask != 0 && ( value & mask ) == 0; mask <<= 1 ) ++count;
+      return count;
+    }
+  }
+}
+
+using qsense::QString;
+using qsense::Reading;
+using qsense::SeriesBatch;
+
+
+SeriesBatch::SeriesBatch( uint16_t max ) : series(), maxBytes( max ), count( 0 ) {}
+
+
+bool SeriesBatch::add( const Reading& reading )
+{
+  if ( reading.getType() == Reading::Text ) return false;
+
+  const qsense::Symbol& key = reading.getKeySymbol();
+  if ( ! key.isValid() || count == 0xFFFF ) return false;
+
+  const float f = reading.getFloat();
+  uint32_t value;
+  memcpy( &value, &f, sizeof( value ) );
+
+  Series* s = NULL;
+  for ( std::size_t i = 0; i < series.size(); ++i )
+  {
+    if ( series[i].key == key ) s = &series[i];
+  }
+
+  const std::size_t growth = ( s == NULL ) ?
+    qsense::series::seriesBytes + key.str().size() : qsense::series::maxPointBytes;
+  if ( count > 0 && bytes() + growth > maxBytes ) return false;
+
+  if ( s == NULL )
+  {
+    series.push_back( Series() );
+    s = &series.back();
+    s->key = key;
+    s->timestamp = reading.getTimestamp();
+    s->delta = 0;
+    s->value = value;
+    s->points = 1;
+    s->leading = 0xFF;
+    s->length = 0;
+    s->free = 0;
+
+    write( *s, uint32_t( uint64_t( s->timestamp ) >> 32 ), 32 );
+    write( *s, uint32_t( s->timestamp ), 32 );
+    write( *s, value, 32 );
+    ++count;
+    return true;
+  }
+
+  if ( s->points == 0xFFFF ) return false;
+
+  // Both the delta and the delta of delta must fit in 32 bits
+  const int64_t delta = reading.getTimestamp() - s->timestamp;
+  const int64_t dod = delta - s->delta;
+  if ( delta != int32_t( delta ) || dod != int32_t( dod ) ) return false;
+
+  writeTimestamp( *s, int32_t( dod ) );
+  writeValue( *s, value );
+
+  s->timestamp = reading.getTimestamp();
+  s->delta = int32_t( delta );
+  ++s->points;
+  ++count;
+  return true;
+}
+
+
+std::size_t SeriesBatch::bytes() const
+{
+  using qsense::series::varintSize;
+
+  const QString& stream = qsense::Event::getStream();
+  std::size_t size = 3 + 16 + varintSize( stream.size() ) + stream.size() + 8 +
+    varintSize( series.size() );
+
+  for ( std::size_t i = 0; i < series.size(); ++i )
+  {
+    const Series& s = series[i];
+    const QString& key = s.key.str();
+    size += varintSize( key.size() ) + key.size() + varintSize( s.points ) +
+      varintSize( s.bits.size() ) + s.bits.size();
+  }
+
+  return size;
+}
+
+
+void SeriesBatch::encode( qsense::Sink& sink ) const
+{
+  using namespace qsense::series;
+
+  qsense::SinkBuffer out( sink );
+
+  out.sputc( 'Q' );
+  out.sputc( 'S' );
+  out.sputc( static_cast<char>( version ) );
+
+  char deviceId[16];
+  qsense::Event::getDeviceId().copyTo( deviceId );
+  out.sputn( deviceId, sizeof( deviceId ) );
+
+  text( out, qsense::Event::getStream() );
+  number( out, qsense::Event::getDefaultLocation().getLatitude() );
+  number( out, qsense::Event::getDefaultLocation().getLongitude() );
+
+  varint( out, series.size() );
+  for ( std::size_t i = 0; i < series.size(); ++i )
+  {
+    const Series& s = series[i];
+    text( out, s.key.str() );
+    varint( out, s.points );
+    text( out, s.bits );
+  }
+
+  out.pubsync();
+}
+
+
+void SeriesBatch::clear()
+{
+  series.clear();
+  count = 0;
+}
+
+
+void SeriesBatch::write( Series& s, uint32_t value, uint8_t bits )
+{
+  while ( bits > 0 )
+  {
+    if ( s.free == 0 )
+    {
+      s.bits.push_back( '\0' );
+      s.free = 8;
+    }
+
+    const uint8_t take = ( bits < s.free ) ? bits : s.free;
+    const uint8_t chunk = uint8_t( value >> ( bits - take ) ) & uint8_t( ( 1 << take ) - 1 );
+
+    s.bits[s.bits.size() - 1] |= static_cast<char>( chunk << ( s.free - take ) );
+    s.free -= take;
+    bits -= take;
+  }
+}
+
+
+void SeriesBatch::writeTimestamp( Series& s, int32_t dod )
+{
+  if ( dod == 0 ) write( s, 0, 1 );
+  else if ( dod >= -64 && dod <= 63 )
+  {
+    write( s, 0x2, 2 );
+    write( s, uint32_t( dod ), 7 );
+  }
+  else if ( dod >= -256 && dod <= 255 )
+  {
+    write( s, 0x6, 3 );
+    write( s, uint32_t( dod ), 9 );
+  }
+  else if ( dod >= -2048 && dod <= 2047 )
+  {
+    write( s, 0xE, 4 );
+    write( s, uint32_t( dod ), 12 );
+  }
+  else
+  {
+    write( s, 0xF, 4 );
+    write( s, uint32_t( dod ), 32 );
+  }
+}
+
+
+void SeriesBatch::writeValue( Series& s, uint32_t value )
+{
+  const uint32_t x = value ^ s.value;
+  s.value = value;
+
+  if ( x == 0 )
+  {
+    write( s, 0, 1 );
+    return;
+  }
+
+  const uint8_t leading = qsense::series::leadingZeros( x );
+  const uint8_t trailing = qsense::series::trailingZeros( x );
+
+  // Reuse the previous window of significant bits if the XOR fits in it
+  if ( s.leading != 0xFF && leading >= s.leading &&
+      trailing >= 32 - s.leading - s.length )
+  {
+    write( s, 0x2, 2 );
+    write( s, x >> ( 32 - s.leading - s.length ), s.length );
+    return;
+  }
+
+  s.leading = leading;
+  s.length = 32 - leading - trailing;
+
+  write( s, 0x3, 2 );
+  write( s, leading, 5 );
+  write( s, s.length - 1, 5 );
+  write( s, x >> trailing, s.length );
+}
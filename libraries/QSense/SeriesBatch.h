@@ -0,0 +1,145 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef QSENSE_SERIESBATCH_H
+#define QSENSE_SERIESBATCH_H
+
+#if defined( ARDUINO )
+#include "QSense.h"
+#include "Reading.h"
+#include "Sink.h"
+#include "Symbol.h"
+#include "../StandardCplusplus/vector"
+#else
+#include <QSense.h>
+#include <Reading.h>
+#include <Sink.h>
+#include <Symbol.h>
+#include <vector>
+#endif
+
+namespace qsense
+{
+  /**
+   * @brief Accumulates many readings of a few keys in a compact columnar
+   * encoding, for devices that sample often and publish seldom.
+   *
+   * Readings are grouped into one series per key, and compressed as they
+   * are added in the manner of Facebook's Gorilla time series database:
+   * timestamps as the difference between successive deltas, so regular
+   * sampling costs a single bit per reading, and values as the XOR with the
+   * previous value, so an unchanged value costs a single bit and a slowly
+   * changing one only its differing bits.  Values are held as single
+   * precision floats, integer and boolean readings are converted, and
+   * string readings are not accepted.
+   *
+   * Publish the batch with
+   * {@link qsense::net::SidecarClient#publish(SeriesBatch&)} instead of an
+   * {@link EventBatch} when this encoding is wanted.  It is not understood
+   * by Sidecar itself, so the receiver must first be set with
+   * {@link qsense::net::SidecarClient#setSeriesEndpoint};
+   * \c extras/series.py is the reference decoder, and the
+   * \c extras/ingest_server.py stand-in server accepts it.
+   *
+   * The encoding, with all integers big endian and bits written most
+   * significant first:
+   *
+   * \code
+   * batch  := 'Q' 'S' version:8 deviceId:128 stream:text latitude:f32
+   *           longitude:f32 count:varint series{count}
+   * series := key:text points:varint length:varint bits{length bytes}
+   * bits   := timestamp:64 value:32 ( dod value ){points - 1} padding
+   * dod    := '0' | '10' int:7 | '110' int:9 | '1110' int:12 | '1111' int:32
+   * value  := '0' | '10' xor-in-previous-window
+   *         | '11' leading:5 (length - 1):5 xor:length
+   * text   := length:varint bytes
+   * \endcode
+   *
+   * where \c varint is an unsigned LEB128 integer, \c dod the difference
+   * between the current and previous timestamp deltas in milli seconds
+   * (the first delta is taken relative to \c 0) as a two's complement
+   * integer, and \c xor the significant bits of the XOR of the current and
+   * previous float values.
+   */
+  class SeriesBatch
+  {
+  public:
+    /// Version of the encoding written.
+    static const uint8_t version = 1;
+
+    /// Return the value for the \c Content-Type header of the batch.
+    static const char* contentType() { return "application/x-qsense-series"; }
+
+    /**
+     * @brief Create a new batch.
+     * @param maxBytes The maximum size of the encoded batch.  A reading
+     *   that might take the batch over this size is not added.
+     */
+    SeriesBatch( uint16_t maxBytes = 1024 );
+
+    /// Destructor.  No actions required.
+    ~SeriesBatch() {}
+
+    /**
+     * @brief Add the specified reading to the series for its key.
+     * @return Returns \c false if the batch is full, in which case the
+     *   batch should be published and the reading added again, or if the
+     *   reading holds a string or is more than 24 days from the previous
+     *   reading of the same key.
+     */
+    bool add( const Reading& reading );
+
+    /// Return the number of readings in the batch.
+    std::size_t size() const { return count; }
+
+    /// Return \c true if there are no readings in the batch.
+    bool empty() const { return count == 0; }
+
+    /// Return the size in bytes of the encoded batch.
+    std::size_t bytes() const;
+
+    /// Write the encoded batch to the sink.
+    void encode( Sink& sink ) const;
+
+    /// Remove all readings from the batch.
+    void clear();
+
+  private:
+    /// The encoded readings of one key, and the state needed to add more.
+    struct Series
+    {
+      Symbol key;
+      QString bits;
+      int64_t timestamp;
+      int32_t delta;
+      uint32_t value;
+      uint16_t points;
+      uint8_t leading;
+      uint8_t length;
+      uint8_t free;
+    };
+
+    void write( Series& series, uint32_t value, uint8_t bits );
+    void writeTimestamp( Series& series, int32_t dod );
+    void writeValue( Series& series, uint32_t value );
+
+  private:
+    std::vector<Series> series;
+    uint16_t maxBytes;
+    uint16_t count;
+  };
+
+} // namespace qsense
+
+#endif // QSENSE_SERIESBATCH_H
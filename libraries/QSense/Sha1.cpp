@@ -8,6 +8,7 @@
 #endif
 
 using qsense::Byte;
+using qsense::FlashString;
 using qsense::QString;
 
 namespace qsense
@@ -444,36 +445,116 @@ QString Sha1::sign( const QString& privateKey, const QString& httpMethod,
   return sha1::base64( output, 20 );
   */
 
+  Key key;
+  initKey( key, privateKey );
+  const QString& signature = sign( key, httpMethod, uriPath, date, contentMd5, signatureVersion );
+
+  memset( &key, 0, sizeof( Key ) );
+  return signature;
+}
+
+
+void Sha1::initKey( Key& key, const QString& secret )
+{
   Context ctx;
 
-  Byte* chars = reinterpret_cast<Byte*>( const_cast<char*>( privateKey.c_str() ) );
-  startHmac( &ctx, chars, privateKey.size() );
+  Byte* chars = reinterpret_cast<Byte*>( const_cast<char*>( secret.c_str() ) );
+  startHmac( &ctx, chars, secret.size() );
+  memcpy( key.inner, ctx.state, sizeof( key.inner ) );
 
-  const QString nlc( "\n" );
-  Byte* newline = reinterpret_cast<Byte*>( const_cast<char*>( nlc.c_str() ) );
+  startHash( &ctx );
+  updateHash( &ctx, ctx.opad, 64 );
+  memcpy( key.outer, ctx.state, sizeof( key.outer ) );
 
-  chars = reinterpret_cast<Byte*>( const_cast<char*>( httpMethod.c_str() ) );
-  updateHmac( &ctx, chars, httpMethod.size() );
-  updateHmac( &ctx, newline, nlc.size() );
+  memset( &ctx, 0, sizeof( Context ) );
+}
 
-  chars = reinterpret_cast<Byte*>( const_cast<char*>( uriPath.c_str() ) );
-  updateHmac( &ctx, chars, uriPath.size() );
-  updateHmac( &ctx, newline, nlc.size() );
 
-  chars = reinterpret_cast<Byte*>( const_cast<char*>( date.c_str() ) );
-  updateHmac( &ctx, chars, date.size() );
-  updateHmac( &ctx, newline, nlc.size() );
+QString Sha1::sign( const Key& key, const QString& httpMethod,
+  const QString& uriPath, const QString& date, const QString& contentMd5,
+  const QString& signatureVersion )
+{
+  Context ctx;
+  resume( &ctx, key.inner );
 
-  chars = reinterpret_cast<Byte*>( const_cast<char*>( contentMd5.c_str() ) );
-  updateHmac( &ctx, chars, contentMd5.size() );
-  updateHmac( &ctx, newline, nlc.size() );
+  updateLine( &ctx, httpMethod );
+  updateLine( &ctx, uriPath );
+  updateLine( &ctx, date );
+  updateLine( &ctx, contentMd5 );
 
-  chars = reinterpret_cast<Byte*>( const_cast<char*>( signatureVersion.c_str() ) );
+  Byte* chars = reinterpret_cast<Byte*>( const_cast<char*>( signatureVersion.c_str() ) );
   updateHmac( &ctx, chars, signatureVersion.size() );
 
+  return finishSignature( &ctx, key );
+}
+
+
+QString Sha1::sign( const Key& key, const FlashString& httpMethod,
+  const FlashString& uriPath, const QString& date, const QString& contentMd5 )
+{
+  Context ctx;
+  resume( &ctx, key.inner );
+
+  updateLine( &ctx, httpMethod );
+  updateLine( &ctx, uriPath );
+  updateLine( &ctx, date );
+  updateLine( &ctx, contentMd5 );
+
+  Byte version = '1';
+  updateHmac( &ctx, &version, 1 );
+
+  return finishSignature( &ctx, key );
+}
+
+
+/*
+ * Hash a line of the string to sign, followed by the newline separator
+ */
+void Sha1::updateLine( Context* ctx, const QString& line )
+{
+  Byte* chars = reinterpret_cast<Byte*>( const_cast<char*>( line.c_str() ) );
+  updateHmac( ctx, chars, line.size() );
+
+  Byte newline = '\n';
+  updateHmac( ctx, &newline, 1 );
+}
+
+
+void Sha1::updateLine( Context* ctx, const FlashString& line )
+{
+  char chunk[16];
+  std::size_t position = 0;
+  for ( std::size_t count = line.copy( chunk, sizeof( chunk ) ); count > 0;
+      count = line.copy( chunk, sizeof( chunk ), position ) )
+  {
+    updateHmac( ctx, reinterpret_cast<Byte*>( chunk ), count );
+    position += count;
+  }
+
+  Byte newline = '\n';
+  updateHmac( ctx, &newline, 1 );
+}
+
+
+QString Sha1::finishSignature( Context* ctx, const Key& key )
+{
   Byte output[20];
-  finishHmac( &ctx, output );
+  finishHash( ctx, output );
+  resume( ctx, key.outer );
+  updateHash( ctx, output, 20 );
+  finishHash( ctx, output );
 
-  memset( &ctx, 0, sizeof( Context ) );
+  memset( ctx, 0, sizeof( Context ) );
   return sha1::base64( output, 20 );
 }
+
+
+/*
+ * Restore the state after a 64 byte padded key block was hashed
+ */
+void Sha1::resume( Context *ctx, const unsigned long state[5] )
+{
+    ctx->total[0] = 64;
+    ctx->total[1] = 0;
+    memcpy( ctx->state, state, sizeof( ctx->state ) );
+}
@@ -7,8 +7,10 @@
 #include <inttypes.h>
 #if defined( ARDUINO )
 #include "QSense.h"
+#include "FlashString.h"
 #else
 #include <QSense.h>
+#include <FlashString.h>
 #endif
 
 // SHA1 related functions
@@ -71,6 +73,49 @@ namespace qsense
         const qsense::QString& contentMd5,
         const qsense::QString& signatureVersion = qsense::QString( "1" ) );
 
+      /**
+       * @brief A precomputed HMAC key.  Holds the SHA1 state after the
+       * inner and outer padded key blocks have been hashed, so that
+       * signing with a fixed secret skips those two compressions (and
+       * the key padding) on each request.  Create with {@link #initKey}.
+       */
+      struct Key
+      {
+        unsigned long inner[5];     /*!< state after the inner padding */
+        unsigned long outer[5];     /*!< state after the outer padding */
+      };
+
+      /**
+       * @brief Precompute the HMAC key state for the specified secret.
+       * @param key The key to initialise.
+       * @param secret The secret to precompute the state for.
+       */
+      void initKey( Key& key, const qsense::QString& secret );
+
+      /**
+       * @brief Generate the signature for the Sidecar Authorization header
+       * using a precomputed key.
+       * @see #sign(const qsense::QString&,const qsense::QString&,const qsense::QString&,const qsense::QString&,const qsense::QString&,const qsense::QString&)
+       */
+      qsense::QString sign( const Key& key,
+        const qsense::QString& httpMethod,
+        const qsense::QString& uriPath,
+        const qsense::QString& date,
+        const qsense::QString& contentMd5,
+        const qsense::QString& signatureVersion = qsense::QString( "1" ) );
+
+      /**
+       * @brief Generate the signature for the Sidecar Authorization header
+       * using a precomputed key, for a method and uri stored in flash.
+       * The method and uri are hashed directly from flash.
+       * @see #sign(const Key&,const qsense::QString&,const qsense::QString&,const qsense::QString&,const qsense::QString&,const qsense::QString&)
+       */
+      qsense::QString sign( const Key& key,
+        const qsense::FlashString& httpMethod,
+        const qsense::FlashString& uriPath,
+        const qsense::QString& date,
+        const qsense::QString& contentMd5 );
+
       /// SHA1 context representation
       struct Context
       {
@@ -90,6 +135,12 @@ namespace qsense
       void startHmac( Context* ctx, unsigned char* key, int keylen );
       void updateHmac( Context* ctx, unsigned char* input, int ilen );
       void finishHmac( Context* ctx, unsigned char output[20] );
+
+      void updateLine( Context* ctx, const qsense::QString& line );
+      void updateLine( Context* ctx, const qsense::FlashString& line );
+      qsense::QString finishSignature( Context* ctx, const Key& key );
+
+      void resume( Context* ctx, const unsigned long state[5] );
     };
   }
 }
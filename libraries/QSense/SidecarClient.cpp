@@ -15,6 +15,9 @@ limitations under the License.
 #include "SidecarClient.h"
 #include "DateTime.h"
 #include "QHttpClient.h"
+#include "RequestTemplate.h"
+
+#include "Sink.h"
 
 #if defined( ARDUINO )
 #include "MD5.h"
@@ -39,38 +42,194 @@ namespace qsense
     namespace data
     {
       static QString apiKey;
-      static QString apiSecret;
+      static qsense::hash::Sha1::Key apiSecret;
       static bool SidecarClientAPIInitialised = false;
 
       static QString userKey;
-      static QString userSecret;
+      static qsense::hash::Sha1::Key userSecret;
       static bool SidecarClientUserInitialised = false;
 
-      static const QString server( "api.sidecar.io" );
-      static const QString POST( "POST" );
-      static const QString DELETE( "DELETE" );
+      // Constant strings are stored in flash, see FlashString
+#define QSENSE_EVENT_URI "/rest/v1/event"
+
+      static const char server[] PROGMEM = "api.sidecar.io";
+      static const char POST[] PROGMEM = "POST";
+      static const char DELETE[] PROGMEM = "DELETE";
+      static const char eventUri[] PROGMEM = QSENSE_EVENT_URI;
+      static const char userUri[] PROGMEM = "/rest/v1/provision/application/user/";
+      static const char accessKeyUri[] PROGMEM = "/rest/v1/provision/application/accesskey/";
+      static const char authUri[] PROGMEM = "/rest/v1/provision/application/auth/";
+
+      /// Headers common to all event API requests, see RequestTemplate::Slot
+#define QSENSE_EVENT_HEADERS \
+        "Host: " "\1" "\r\n" \
+        "Content-Type: " "\2" "\r\n" \
+        "Signature-Version: 1\r\n" \
+        "Date: " "\3" "\r\n" \
+        "Content-MD5: " "\4" "\r\n" \
+        "Content-Length: " "\5" "\r\n" \
+        "Authorization: SIDECAR " "\6" ":" "\7" "\r\n" \
+        "\r\n"
+
+      static const char eventHead[] PROGMEM =
+        "POST " QSENSE_EVENT_URI " HTTP/1.1\r\n" QSENSE_EVENT_HEADERS;
+      /// Batches are sent to the uri set with SidecarClient::setBatchEndpoint
+      static const char batchHead[] PROGMEM =
+        "POST " "\10" " HTTP/1.1\r\n" QSENSE_EVENT_HEADERS;
+
+#undef QSENSE_EVENT_HEADERS
+#undef QSENSE_EVENT_URI
+
+      static const RequestTemplate eventRequest( eventHead, eventUri );
+
+      /// Queued events are sent in batches no larger than an EventBatch
+      static const std::size_t batchBytes = 1024;
+
+      /// Responses refusing the event itself, which will not be accepted
+      /// if it is sent again.
+      bool rejected( uint16_t responseCode )
+      {
+        return ( responseCode == 400 ) || ( responseCode == 413 ) || ( responseCode == 422 );
+      }
+
+      /// Failures for which the request may succeed if sent again later.
+      /// Besides an unreachable or failing server this includes responses
+      /// such as 401 for a request signed while the clock is wrong, or 404
+      /// from an endpoint that is not available, which say nothing about
+      /// the event and must not lose it.
+      bool retriable( uint16_t responseCode )
+      {
+        return ( responseCode < 200 || responseCode >= 300 ) && ! rejected( responseCode );
+      }
 
       const QString credentials( const QString& username, const QString& password )
       {
         std::stringstream ss;
-        ss << "{\"username\":\"" << username <<
-          "\",\"password\":\"" << password << "\"}";
+        ss << F( "{\"username\":\"" ) << username <<
+          F( "\",\"password\":\"" ) << password << F( "\"}" );
         return ss.str();
       }
+
+      /// Computes the length and MD5 hash of data without retaining it
+      struct DigestSink : qsense::Sink
+      {
+        DigestSink() : md5(), length( 0 ) { md5.init(); }
+
+        void write( const char* data, std::size_t size )
+        {
+          md5.update( data, size );
+          length += size;
+        }
+
+        qsense::hash::MD5 md5;
+        std::size_t length;
+      };
+
+      /// Writes data directly to the connection to the server
+      struct ClientSink : qsense::Sink
+      {
+        ClientSink( HttpClient& c ) : client( c ), failed( false ) {}
+
+        void write( const char* data, std::size_t size )
+        {
+          if ( client.write( data, size ) != size ) failed = true;
+        }
+
+        HttpClient& client;
+        bool failed;
+      };
+
+      /// The values for the head of a signed event API request.  Holds
+      /// the date and signature referenced by the values.
+      class SignedHead
+      {
+      public:
+        SignedHead( const RequestTemplate& request, const QString& host,
+            const QString& hash, std::size_t length, const char* contentType ) :
+          date( DateTime::singleton().currentTime() ), hash( hash ),
+          signature(), values()
+        {
+          qsense::hash::Sha1 sha1;
+          signature = sha1.sign( userSecret, qsense::FlashString( POST ),
+            request.getUri(), date, this->hash );
+
+          values.set( RequestTemplate::Host, host );
+          values.set( RequestTemplate::ContentType, contentType );
+          values.set( RequestTemplate::Date, date );
+          values.set( RequestTemplate::ContentMD5, this->hash );
+          values.set( RequestTemplate::ContentLength, uint32_t( length ) );
+          values.set( RequestTemplate::AccessKey, userKey );
+          values.set( RequestTemplate::Signature, signature );
+        }
+
+        const RequestTemplate::Values& getValues() const { return values; }
+
+      private:
+        SignedHead( const SignedHead& );
+        SignedHead& operator=( const SignedHead& );
+
+        const QString date;
+        const QString hash;
+        QString signature;
+        RequestTemplate::Values values;
+      };
+
+      /// Write the request head and body to the connection.
+      uint16_t send( HttpClient& client, const RequestTemplate& request,
+        const RequestTemplate::Values& values, const QString& body )
+      {
+        client.startRequest();
+
+        ClientSink sink( client );
+        request.render( sink, values );
+        sink.write( body.data(), body.size() );
+
+        if ( sink.failed || ! client.connected() ) return 0;
+        return client.readStatus();
+      }
+
+      const QString serialise( const qsense::Encoder& encoder, const EventBase& event,
+        const qsense::UUID& id, int64_t timestamp )
+      {
+        QString str;
+        qsense::StringSink sink( str );
+        encoder.encode( sink, event, id, timestamp );
+        return str;
+      }
     }
   }
 }
 
+using qsense::FlashString;
+using qsense::JsonEncoder;
 using qsense::QString;
+using qsense::net::RequestTemplate;
 using qsense::net::SidecarClient;
 
 
+SidecarClient::SidecarClient() :
+  connection( FlashString( qsense::net::data::server ).toString() ), queue(), request( connection ),
+  encoder( &JsonEncoder::singleton() ),
+  callback( NULL ), context( NULL ), queued( 0 ), priority( 0 ),
+  included( false ), batchRequest( qsense::net::data::batchHead, NULL ),
+  seriesServer(), seriesUri( NULL ), seriesPort( 80 ) {}
+
+
+SidecarClient::SidecarClient( const QString& server, uint16_t port ) :
+  connection( server, port ), queue(), request( connection ),
+  encoder( &JsonEncoder::singleton() ),
+  callback( NULL ), context( NULL ), queued( 0 ), priority( 0 ),
+  included( false ), batchRequest( qsense::net::data::batchHead, NULL ),
+  seriesServer(), seriesUri( NULL ), seriesPort( 80 ) {}
+
+
 void SidecarClient::initAPIKey( const QString& apiKey, const QString& apiSecret )
 {
   if ( ! qsense::net::data::SidecarClientAPIInitialised )
   {
     qsense::net::data::apiKey = apiKey;
-    qsense::net::data::apiSecret = apiSecret;
+    qsense::hash::Sha1 sha1;
+    sha1.initKey( qsense::net::data::apiSecret, apiSecret );
     qsense::net::data::SidecarClientAPIInitialised = true;
   }
 }
@@ -81,7 +240,8 @@ void SidecarClient::initUserKey( const QString& userKey, const QString& userSecr
   if ( ! qsense::net::data::SidecarClientUserInitialised )
   {
     qsense::net::data::userKey = userKey;
-    qsense::net::data::userSecret = userSecret;
+    qsense::hash::Sha1 sha1;
+    sha1.initKey( qsense::net::data::userSecret, userSecret );
     qsense::net::data::SidecarClientUserInitialised = true;
   }
 }
@@ -109,42 +269,40 @@ SidecarClient::UserResponse SidecarClient::createUser(
   using qsense::net::HttpClient;
   using qsense::net::HttpRequest;
 
-  static QString uri( "/rest/v1/provision/application/user/" );
-
   uint16_t responseCode = uint16_t( 500 );
   const QString& currentTime = DateTime::singleton().currentTime();
 
   HttpClient::Ptr client = HttpClient::create();
 
-  if ( client->connect( data::server ) )
+  if ( client->connect( FlashString( data::server ).toString() ) )
   {
 #if DEBUG
-    std::cout << F( "Connected to " ) << data::server << std::endl;
+    std::cout << F( "Connected to " ) << FlashString( data::server ) << std::endl;
 #endif
 
     const QString& json = data::credentials( username, password );
     const QString& hash = md5( json );
 
-    HttpRequest request( uri );
-    request.setHeader( "Date", currentTime );
-    request.setHeader( "Content-Type", "application/json" );
-    request.setHeader( "Content-MD5", hash );
-    request.setHeader( "Signature-Version", "1" );
+    HttpRequest request( FlashString( data::userUri ).toString() );
+    request.setHeader( HttpRequest::Date, currentTime );
+    request.setHeader( HttpRequest::ContentType, "application/json" );
+    request.setHeader( HttpRequest::ContentMD5, hash );
+    request.setHeader( HttpRequest::SignatureVersion, "1" );
 
     {
       std::stringstream ss;
       ss << json.length();
-      request.setHeader( "Content-Length", ss.str() );
+      request.setHeader( HttpRequest::ContentLength, ss.str() );
     }
 
     std::stringstream ss;
-    ss << "SIDECAR " <<
+    ss << F( "SIDECAR " ) <<
       qsense::net::data::apiKey <<
       ':' <<
       signature( qsense::net::data::apiSecret,
-        data::POST, uri, currentTime, hash );
+        FlashString( data::POST ), FlashString( data::userUri ), currentTime, hash );
 
-    request.setHeader( "Authorization", ss.str() );
+    request.setHeader( HttpRequest::Authorization, ss.str() );
 
     request.setBody( json );
 
@@ -178,41 +336,40 @@ SidecarClient::UserResponse SidecarClient::createOrRetrieveAccessKeys(
   using qsense::net::HttpClient;
   using qsense::net::HttpRequest;
 
-  static QString uri( "/rest/v1/provision/application/accesskey/" );
-
   uint16_t responseCode = uint16_t( 500 );
   const QString& currentTime = DateTime::singleton().currentTime();
 
   HttpClient::Ptr client = HttpClient::create();
 
-  if ( client->connect( data::server ) )
+  if ( client->connect( FlashString( data::server ).toString() ) )
   {
 #if DEBUG
-    std::cout << F( "Connected to " ) << data::server << std::endl;
+    std::cout << F( "Connected to " ) << FlashString( data::server ) << std::endl;
 #endif
 
     const QString& json = data::credentials( username, password );
     const QString& hash = md5( json );
 
-    HttpRequest request( uri );
-    request.setHeader( "Date", currentTime );
-    request.setHeader( "Content-Type", "application/json" );
-    request.setHeader( "Content-MD5", hash );
-    request.setHeader( "Signature-Version", "1" );
+    HttpRequest request( FlashString( data::accessKeyUri ).toString() );
+    request.setHeader( HttpRequest::Date, currentTime );
+    request.setHeader( HttpRequest::ContentType, "application/json" );
+    request.setHeader( HttpRequest::ContentMD5, hash );
+    request.setHeader( HttpRequest::SignatureVersion, "1" );
 
     {
       std::stringstream ss;
       ss << json.length();
-      request.setHeader( "Content-Length", ss.str() );
+      request.setHeader( HttpRequest::ContentLength, ss.str() );
     }
 
     std::stringstream ss;
-    ss << "SIDECAR " <<
+    ss << F( "SIDECAR " ) <<
       qsense::net::data::apiKey <<
       ':' <<
-      signature( qsense::net::data::apiSecret, data::POST, uri, currentTime, hash );
+      signature( qsense::net::data::apiSecret,
+        FlashString( data::POST ), FlashString( data::accessKeyUri ), currentTime, hash );
 
-    request.setHeader( "Authorization", ss.str() );
+    request.setHeader( HttpRequest::Authorization, ss.str() );
 
     request.setBody( json );
 
@@ -246,40 +403,39 @@ SidecarClient::UserResponse SidecarClient::authenticate(
   using qsense::net::HttpClient;
   using qsense::net::HttpRequest;
 
-  static QString uri( "/rest/v1/provision/application/auth/" );
-
   uint16_t responseCode = uint16_t( 500 );
   const QString& currentTime = DateTime::singleton().currentTime();
 
   HttpClient::Ptr client = HttpClient::create();
 
-  if ( client->connect( data::server ) )
+  if ( client->connect( FlashString( data::server ).toString() ) )
   {
 #if DEBUG
-    std::cout << F( "Connected to " ) << data::server << std::endl;
+    std::cout << F( "Connected to " ) << FlashString( data::server ) << std::endl;
 #endif
 
     const QString& json = data::credentials( username, password );
     const QString& hash = md5( json );
 
-    HttpRequest request( uri );
-    request.setHeader( "Date", currentTime );
-    request.setHeader( "Content-Type", "application/json" );
-    request.setHeader( "Content-MD5", hash );
-    request.setHeader( "Signature-Version", "1" );
+    HttpRequest request( FlashString( data::authUri ).toString() );
+    request.setHeader( HttpRequest::Date, currentTime );
+    request.setHeader( HttpRequest::ContentType, "application/json" );
+    request.setHeader( HttpRequest::ContentMD5, hash );
+    request.setHeader( HttpRequest::SignatureVersion, "1" );
 
     {
       std::stringstream ss;
       ss << json.length();
-      request.setHeader( "Content-Length", ss.str() );
+      request.setHeader( HttpRequest::ContentLength, ss.str() );
     }
 
     std::stringstream ss;
-    ss << "SIDECAR " <<
+    ss << F( "SIDECAR " ) <<
       qsense::net::data::apiKey <<
       ':' <<
-      signature( qsense::net::data::apiSecret, data::POST, uri, currentTime, hash );
-    request.setHeader( "Authorization", ss.str() );
+      signature( qsense::net::data::apiSecret,
+        FlashString( data::POST ), FlashString( data::authUri ), currentTime, hash );
+    request.setHeader( HttpRequest::Authorization, ss.str() );
 
     request.setBody( json );
 
@@ -312,40 +468,39 @@ int16_t SidecarClient::deleteUser( const QString& username, const QString& passw
   using qsense::net::HttpClient;
   using qsense::net::HttpRequest;
 
-  static QString uri( "/rest/v1/provision/application/user/" );
-
   uint16_t responseCode = uint16_t( 500 );
   const QString& currentTime = DateTime::singleton().currentTime();
 
   HttpClient::Ptr client = HttpClient::create();
 
-  if ( client->connect( data::server ) )
+  if ( client->connect( FlashString( data::server ).toString() ) )
   {
 #if DEBUG
-    std::cout << F( "Connected to " ) << data::server << std::endl;
+    std::cout << F( "Connected to " ) << FlashString( data::server ) << std::endl;
 #endif
 
     const QString& json = data::credentials( username, password );
     const QString& hash = md5( json );
 
-    HttpRequest request( uri );
-    request.setHeader( "Date", currentTime );
-    request.setHeader( "Content-Type", "application/json" );
-    request.setHeader( "Content-MD5", hash );
-    request.setHeader( "Signature-Version", "1" );
+    HttpRequest request( FlashString( data::userUri ).toString() );
+    request.setHeader( HttpRequest::Date, currentTime );
+    request.setHeader( HttpRequest::ContentType, "application/json" );
+    request.setHeader( HttpRequest::ContentMD5, hash );
+    request.setHeader( HttpRequest::SignatureVersion, "1" );
 
     {
       std::stringstream ss;
       ss << json.length();
-      request.setHeader( "Content-Length", ss.str() );
+      request.setHeader( HttpRequest::ContentLength, ss.str() );
     }
 
     std::stringstream ss;
-    ss << "SIDECAR " <<
+    ss << F( "SIDECAR " ) <<
       qsense::net::data::apiKey <<
       ':' <<
-      signature( qsense::net::data::apiSecret, data::DELETE, uri, currentTime, hash );
-    request.setHeader( "Authorization", ss.str() );
+      signature( qsense::net::data::apiSecret,
+        FlashString( data::DELETE ), FlashString( data::userUri ), currentTime, hash );
+    request.setHeader( HttpRequest::Authorization, ss.str() );
 
     request.setBody( json );
 
@@ -359,69 +514,408 @@ int16_t SidecarClient::deleteUser( const QString& username, const QString& passw
 }
 
 
-bool SidecarClient::publish( const qsense::Event& event ) const
+bool SidecarClient::publish( const qsense::EventBase& event, uint8_t priority )
 {
+  using qsense::UUID;
   using qsense::net::DateTime;
+
+  // Fixed up front so that every serialisation pass is identical
+  const UUID id = UUID::create();
+  const int64_t timestamp = DateTime::singleton().currentTimeMillis();
+
+  // The connection may be in use by a publish started with beginPublish,
+  // and previously queued events must be published first.
+  if ( request.isActive() || ! drain() )
+  {
+    queue.push( data::serialise( *encoder, event, id, timestamp ), priority );
+    return false;
+  }
+
+  QString response;
+  const uint16_t responseCode = post( event, id, timestamp, response );
+#if DEBUG
+  std::cout << F( "Event API returned HTTP response code: " ) << responseCode << std::endl;
+#endif
+
+  if ( responseCode == 202 ) return true;
+
+  if ( data::retriable( responseCode ) )
+  {
+    queue.push( data::serialise( *encoder, event, id, timestamp ), priority );
+  }
+  if ( response.size() ) std::cout << F( "  [resp] " ) << response << std::endl;
+  return false;
+}
+
+
+void SidecarClient::setBatchEndpoint( const char* uri )
+{
+  batchRequest = RequestTemplate( data::batchHead, uri );
+}
+
+
+bool SidecarClient::publish( qsense::EventBatch& batch )
+{
+  // The Sidecar Event API is only known to accept one event per request
+  if ( ! batching() ) return false;
+  if ( batch.empty() ) return true;
+
+  QString response;
+  const uint16_t responseCode = post( batchRequest, batch.getBody(),
+      JsonEncoder::singleton().contentType(), response );
+#if DEBUG
+  std::cout << F( "Event API returned HTTP response code: " ) << responseCode << std::endl;
+#endif
+
+  // Nothing reached Sidecar, retain the batch so that it may be retried
+  if ( responseCode == 0 ) return false;
+
+  batch.notify( responseCode, response );
+  batch.clear();
+
+  if ( responseCode == 202 || responseCode == 207 ) return true;
+
+  if ( response.size() ) std::cout << F( "  [resp] " ) << response << std::endl;
+  return false;
+}
+
+
+void SidecarClient::setSeriesEndpoint( const QString& server, const char* uri, uint16_t port )
+{
+  seriesServer = server;
+  seriesUri = uri;
+  seriesPort = port;
+}
+
+
+bool SidecarClient::publish( qsense::SeriesBatch& batch )
+{
   using qsense::net::HttpClient;
   using qsense::net::HttpRequest;
 
-  static QString uri( "/rest/v1/event" );
-
-  bool flag = false;
-  const QString& currentTime = DateTime::singleton().currentTime();
+  // Never sent to the Sidecar Event API, which does not accept the encoding
+  if ( seriesServer.empty() || seriesUri == NULL ) return false;
+  if ( batch.empty() ) return true;
 
   HttpClient::Ptr client = HttpClient::create();
+  if ( ! client->connect( seriesServer, seriesPort ) ) return false;
+
+  QString body;
+  qsense::StringSink sink( body );
+  batch.encode( sink );
+
+  HttpRequest req( FlashString( seriesUri ).toString() );
+  sign( req, FlashString( seriesUri ), body, qsense::SeriesBatch::contentType() );
+
+  const uint16_t responseCode = client->post( req );
+#if DEBUG
+  std::cout << F( "Series receiver returned HTTP response code: " ) << responseCode << std::endl;
+#endif
 
-  if ( client->connect( data::server ) )
+  // Only a batch accepted, or refused as such, is cleared
+  if ( ! data::retriable( responseCode ) ) batch.clear();
+  if ( responseCode == 202 ) return true;
+  if ( responseCode == 0 ) return false;
+
+  const QString& response = client->readBody();
+  if ( response.size() ) std::cout << F( "  [resp] " ) << response << std::endl;
+  return false;
+}
+
+
+bool SidecarClient::beginPublish( const qsense::EventBase& event,
+    PublishCallback cb, void* ctx, uint8_t prio )
+{
+  using qsense::UUID;
+  using qsense::net::DateTime;
+  using qsense::net::HttpRequest;
+
+  if ( request.isActive() ) return false;
+
+  callback = cb;
+  context = ctx;
+  priority = prio;
+  queued = 0;
+  included = true;
+
+  QString body( data::serialise( *encoder, event, UUID::create(),
+      DateTime::singleton().currentTimeMillis() ) );
+  const RequestTemplate* endpoint = &data::eventRequest;
+  const char* contentType = encoder->contentType();
+
+  // Preserve ordering, send the oldest queued events first.  The request
+  // holds its body until it completes, so the events are copied into it.
+  if ( ! queue.empty() )
   {
+    const bool pushed = queue.push( body, priority );
+    queued = next( endpoint, contentType );
+    included = pushed && queued == queue.size();
+    queue.pin( queued );
+
+    body.clear();
+    qsense::StringSink sink( body );
+    write( sink, *endpoint, queued );
+  }
+
+  HttpRequest* req = new HttpRequest( endpoint->getUri().toString() );
+  sign( *req, endpoint->getUri(), body, contentType );
+  return request.begin( FlashString( data::POST ).toString(), req );
+}
+
+
+bool SidecarClient::poll()
+{
+  if ( ! request.isActive() ) return false;
+
+  request.poll();
+  if ( request.isActive() ) return true;
+
+  const uint16_t responseCode = request.getResponseCode();
 #if DEBUG
-    std::cout << F( "Connected to " ) << data::server << std::endl;
+  std::cout << F( "Event API returned HTTP response code: " ) << responseCode << std::endl;
 #endif
 
-    const QString& eventJson = event.toString();
-    const QString& hash = md5( eventJson );
+  // Events pushed while the request was active sit behind the pinned ones
+  const bool retry = data::retriable( responseCode );
+  queue.release( ! retry );
+  if ( retry && queued == 0 ) queue.push( request.getRequest()->getBody(), priority );
 
-    HttpRequest request( uri );
-    request.setHeader( "Date", currentTime );
-    request.setHeader( "Content-Type", "application/json" );
-    request.setHeader( "Content-MD5", hash );
-    request.setHeader( "Signature-Version", "1" );
+  if ( callback != NULL ) callback( included && responseCode == 202, responseCode, context );
+  request.reset();
+  return false;
+}
 
-    {
-      std::stringstream ss;
-      ss << eventJson.length();
-      request.setHeader( "Content-Length", ss.str() );
-    }
 
-    std::stringstream ss;
-    ss << "SIDECAR " <<
-      qsense::net::data::userKey <<
-      ':' <<
-      signature( qsense::net::data::userSecret, data::POST, uri, currentTime, hash );
-    request.setHeader( "Authorization", ss.str() );
+bool SidecarClient::drain()
+{
+  if ( request.isActive() ) return false;
 
-    request.setBody( eventJson );
+  while ( ! queue.empty() )
+  {
+    const RequestTemplate* endpoint = NULL;
+    const char* contentType = NULL;
+    const std::size_t number = next( endpoint, contentType );
 
-    uint16_t responseCode = client->post( request );
+    QString response;
+    const uint16_t responseCode = post( *endpoint, number, contentType, response );
 #if DEBUG
-    std::cout << F( "Event API returned HTTP response code: " ) << responseCode << std::endl;
+    std::cout << F( "Drained " ) << number << F( " queued events, response code: " ) << responseCode << std::endl;
 #endif
 
-    if ( responseCode == 202 ) flag = true;
-    else
-    {
-      while ( client->connected() )
-      {
-        std::cout << F( "  [resp] " ) << client->readLine() << std::endl;
-      }
-    }
+    // Only events accepted, or refused as such, leave the queue
+    if ( data::retriable( responseCode ) ) return false;
+    queue.pop( number );
   }
-  else
+
+  return true;
+}
+
+
+uint16_t SidecarClient::post( const qsense::EventBase& event, const qsense::UUID& id,
+    int64_t timestamp, QString& response )
+{
+  using qsense::net::HttpClient;
+
+  // First pass, compute the length and hash without building the body
+  data::DigestSink digest;
+  encoder->encode( digest, event, id, timestamp );
+
+  const data::SignedHead head( data::eventRequest, connection.getServer(),
+      digest.md5.finish(), digest.length, encoder->contentType() );
+
+  uint16_t responseCode = 0;
+  HttpClient::Ptr client = connection.acquire();
+  if ( client.isNull() ) return responseCode;
+
+  responseCode = send( *client, head.getValues(), event, id, timestamp );
+
+  // Server closed the idle connection after we checked it, retry once
+  if ( responseCode == 0 && connection.reused() )
+  {
+    client = connection.reconnect();
+    if ( client.isNull() ) return responseCode;
+    responseCode = send( *client, head.getValues(), event, id, timestamp );
+  }
+
+  response = client->readBody();
+  connection.release( client->isReusable() );
+
+  return responseCode;
+}
+
+
+uint16_t SidecarClient::send( HttpClient& client, const RequestTemplate::Values& values,
+    const qsense::EventBase& event, const qsense::UUID& id, int64_t timestamp ) const
+{
+  client.startRequest();
+
+  data::ClientSink sink( client );
+  data::eventRequest.render( sink, values );
+
+  // Second pass, write the body straight to the connection
+  encoder->encode( sink, event, id, timestamp );
+
+  if ( sink.failed || ! client.connected() ) return 0;
+  return client.readStatus();
+}
+
+
+uint16_t SidecarClient::post( const RequestTemplate& request, const QString& body,
+    const char* contentType, QString& response )
+{
+  using qsense::net::HttpClient;
+
+  const data::SignedHead head( request, connection.getServer(),
+      md5( body ), body.length(), contentType );
+
+  uint16_t responseCode = 0;
+  HttpClient::Ptr client = connection.acquire();
+  if ( client.isNull() ) return responseCode;
+
+  responseCode = data::send( *client, request, head.getValues(), body );
+
+  // Server closed the idle connection after we checked it, retry once
+  if ( responseCode == 0 && connection.reused() )
   {
-    std::cout << F( "Connection to " ) << data::server << F( " failed" ) << std::endl;
+    client = connection.reconnect();
+    if ( client.isNull() ) return responseCode;
+    responseCode = data::send( *client, request, head.getValues(), body );
+  }
+
+  response = client->readBody();
+  connection.release( client->isReusable() );
+
+  return responseCode;
+}
+
+
+uint16_t SidecarClient::post( const RequestTemplate& request, std::size_t number,
+    const char* contentType, QString& response )
+{
+  using qsense::net::HttpClient;
+
+  // First pass, compute the length and hash without copying the events
+  // out of the queue
+  data::DigestSink digest;
+  write( digest, request, number );
+
+  const data::SignedHead head( request, connection.getServer(),
+      digest.md5.finish(), digest.length, contentType );
+
+  uint16_t responseCode = 0;
+  HttpClient::Ptr client = connection.acquire();
+  if ( client.isNull() ) return responseCode;
+
+  responseCode = send( *client, request, head.getValues(), number );
+
+  // Server closed the idle connection after we checked it, retry once
+  if ( responseCode == 0 && connection.reused() )
+  {
+    client = connection.reconnect();
+    if ( client.isNull() ) return responseCode;
+    responseCode = send( *client, request, head.getValues(), number );
+  }
+
+  response = client->readBody();
+  connection.release( client->isReusable() );
+
+  return responseCode;
+}
+
+
+uint16_t SidecarClient::send( HttpClient& client, const RequestTemplate& request,
+    const RequestTemplate::Values& values, std::size_t number ) const
+{
+  client.startRequest();
+
+  data::ClientSink sink( client );
+  request.render( sink, values );
+
+  // Second pass, write the events straight from the queue to the connection
+  write( sink, request, number );
+
+  if ( sink.failed || ! client.connected() ) return 0;
+  return client.readStatus();
+}
+
+
+std::size_t SidecarClient::next( const RequestTemplate*& request,
+    const char*& contentType ) const
+{
+  request = &data::eventRequest;
+  contentType = encoder->contentType();
+  if ( queue.size() == 1 || ! encoder->supportsBatch() || ! batching() ) return 1;
+
+  request = &batchRequest;
+  contentType = JsonEncoder::singleton().contentType();
+
+  // As many events as an EventBatch would accept, at least one
+  std::size_t bytes = EventBatch::prefix().size() +
+    EventBatch::suffix().size() + queue.length( 0 );
+  std::size_t number = 1;
+  for ( ; number < queue.size() && number < 0xFF; ++number )
+  {
+    const std::size_t size = queue.length( number ) + 2;
+    if ( bytes + size > data::batchBytes ) break;
+    bytes += size;
+  }
+
+  return number;
+}
+
+
+void SidecarClient::write( qsense::Sink& sink, const RequestTemplate& request,
+    std::size_t number ) const
+{
+  if ( &request != &batchRequest )
+  {
+    queue.peek( 0, sink );
+    return;
+  }
+
+  EventBatch::prefix().write( sink );
+  for ( std::size_t i = 0; i < number; ++i )
+  {
+    if ( i > 0 ) sink.write( ", ", 2 );
+    queue.peek( i, sink );
+  }
+  EventBatch::suffix().write( sink );
+}
+
+
+void SidecarClient::sign( HttpRequest& request, const FlashString& uri,
+    const QString& body, const char* contentType ) const
+{
+  sign( request, uri, md5( body ), body.length(), contentType );
+  request.setBody( body );
+}
+
+
+void SidecarClient::sign( HttpRequest& request, const FlashString& uri,
+    const QString& hash, std::size_t length, const char* contentType ) const
+{
+  using qsense::net::DateTime;
+
+  const QString& currentTime = DateTime::singleton().currentTime();
+
+  request.setHeader( HttpRequest::Date, currentTime );
+  request.setHeader( HttpRequest::ContentType, contentType );
+  request.setHeader( HttpRequest::ContentMD5, hash );
+  request.setHeader( HttpRequest::SignatureVersion, "1" );
+
+  {
+    std::stringstream ss;
+    ss << length;
+    request.setHeader( HttpRequest::ContentLength, ss.str() );
   }
 
-  return flag;
+  std::stringstream ss;
+  ss << F( "SIDECAR " ) <<
+    qsense::net::data::userKey <<
+    ':' <<
+    signature( qsense::net::data::userSecret, FlashString( data::POST ),
+      uri, currentTime, hash );
+  request.setHeader( HttpRequest::Authorization, ss.str() );
 }
 
 
@@ -433,8 +927,8 @@ QString SidecarClient::md5( const QString& event ) const
 }
 
 
-QString SidecarClient::signature( const QString& secret,
-    const QString& method, const QString& uri,
+QString SidecarClient::signature( const qsense::hash::Sha1::Key& secret,
+    const FlashString& method, const FlashString& uri,
     const QString& date, const QString& hash ) const
 {
   using qsense::hash::Sha1;
@@ -17,10 +17,26 @@ limitations under the License.
 
 #if defined( ARDUINO )
 #include "QSense.h"
+#include "AsyncRequest.h"
+#include "Connection.h"
+#include "Encoder.h"
 #include "Event.h"
+#include "EventBatch.h"
+#include "EventQueue.h"
+#include "RequestTemplate.h"
+#include "SeriesBatch.h"
+#include "Sha1.h"
 #else
 #include <QSense.h>
+#include <net/AsyncRequest.h>
+#include <net/Connection.h>
+#include <Encoder.h>
 #include <Event.h>
+#include <EventBatch.h>
+#include <EventQueue.h>
+#include <net/RequestTemplate.h>
+#include <SeriesBatch.h>
+#include <hash/Sha1.h>
 #endif
 
 namespace qsense
@@ -33,6 +49,26 @@ namespace qsense
     class SidecarClient
     {
     public:
+      /// Default constructor.  No connection is made until the first publish.
+      SidecarClient();
+
+      /**
+       * @brief Create a client that publishes events to the specified
+       * server instead of Sidecar.  Use with a local stand-in server such
+       * as \c extras/ingest_server.py when testing.
+       */
+      SidecarClient( const QString& server, uint16_t port = 80 );
+
+      /**
+       * @brief Callback invoked when a publish started with
+       * {@link #beginPublish} completes.
+       * @param accepted \c true if Sidecar accepted the event.
+       * @param responseCode The HTTP response code returned by Sidecar,
+       *   or \c 0 if Sidecar could not be reached.
+       * @param context The context pointer passed to {@link #beginPublish}.
+       */
+      typedef void (*PublishCallback)( bool accepted, uint16_t responseCode, void* context );
+
       /// A simple structure that represents the result of a user 
       /// provisioning request.
       struct UserResponse
@@ -100,24 +136,214 @@ namespace qsense
        */
       int16_t deleteUser( const QString& username, const QString& password );
 
-      /// Publish the specified event to the Sidecar Event API
-      bool publish( const Event& event ) const;
+      /**
+       * @brief Publish the specified event to the Sidecar Event API.
+       * Events are published over a persistent connection that is kept
+       * open between calls and re-established if the server closes it.
+       *
+       * The event is encoded twice: once to compute the \c Content-Length
+       * and \c Content-MD5, and once directly to the connection, so the
+       * encoded event is never held in memory in full.
+       *
+       * If Sidecar cannot be reached, or responds with anything other than
+       * acceptance or a refusal of the event itself (\c 400, \c 413 or
+       * \c 422), the event is held in the store-and-forward
+       * {@link #getQueue queue}, and is published after the events queued
+       * before it once the connection is restored.
+       *
+       * @param event The event to publish.
+       * @param priority The priority with which the event is queued if
+       *   it cannot be published.
+       * @return Returns \c true if Sidecar accepted the event.  If a
+       *   publish started with {@link #beginPublish} is in progress, the
+       *   event is queued and \c false is returned.
+       */
+      bool publish( const EventBase& event, uint8_t priority = 0 );
+
+      /**
+       * @brief Start publishing the specified event without blocking.
+       * The request is driven by subsequent calls to {@link #poll}, each
+       * of which performs one step of the exchange as described for
+       * {@link AsyncRequest}, and the result is reported through the
+       * callback.
+       *
+       * If events are held in the store-and-forward queue, the event is
+       * queued behind them and the oldest queued events are sent instead.
+       * The callback then reports the event as accepted only if it was
+       * part of the request that Sidecar accepted.  An event that cannot
+       * be published is queued as with {@link #publish(const EventBase&,uint8_t)}.
+       *
+       * @param event The event to publish.
+       * @param callback Invoked once the publish completes.  May be \c NULL.
+       * @param context Passed through to the callback.
+       * @param priority The priority with which the event is queued if
+       *   it cannot be published.
+       * @return Returns \c false if a publish is already in progress.
+       */
+      bool beginPublish( const EventBase& event, PublishCallback callback = NULL,
+        void* context = NULL, uint8_t priority = 0 );
+
+      /**
+       * @brief Advance the publish started with {@link #beginPublish}.
+       * Invoke from the application loop.
+       * @return Returns \c true while the publish is in progress.
+       */
+      bool poll();
+
+      /// Return \c true if a publish started with {@link #beginPublish}
+      /// has not yet completed.
+      bool isPublishing() const { return request.isActive(); }
+
+      /**
+       * @brief Set the uri on the server to which batches of events are
+       * posted, and queued events are drained in batches.  The Sidecar
+       * Event API is only documented to accept one event per request at
+       * \c /rest/v1/event, so batches are not sent until the uri of a
+       * receiver that accepts them has been set.  Such a receiver is
+       * assumed to take the \c {"events": [...]} body built by
+       * {@link EventBatch} and respond as described for
+       * {@link EventBatch#notify}.
+       * @param uri The uri to post batches to.  On Arduino this must be
+       *   stored in flash using \c PROGMEM, as for {@link RequestTemplate}.
+       */
+      void setBatchEndpoint( const char* uri );
+
+      /**
+       * @brief Publish all the events in the specified batch in a single
+       * request, to the uri set with {@link #setBatchEndpoint}.  The batch
+       * is hashed and signed once.
+       *
+       * If the server responded, the result for each event is reported
+       * through the batch callback and the batch is cleared.  If the
+       * request could not be sent, the batch is left unchanged so that it
+       * may be retried.
+       *
+       * @param batch The batch of events to publish.
+       * @return Returns \c true if the server accepted the batch (all or
+       *   some of the events).  Returns \c false without sending anything
+       *   if no batch endpoint has been set.
+       */
+      bool publish( EventBatch& batch );
+
+      /**
+       * @brief Set the receiver to which {@link SeriesBatch}es are published.
+       * The Sidecar Event API does not accept their encoding, so series
+       * batches are only published once a receiver that does, such as the
+       * ingest server in \c extras, has been set.
+       * @param server The host name of the receiver.
+       * @param uri The uri to post batches to.  On Arduino this must be
+       *   stored in flash using \c PROGMEM, as for {@link RequestTemplate}.
+       * @param port The port of the receiver.
+       */
+      void setSeriesEndpoint( const QString& server, const char* uri, uint16_t port = 80 );
+
+      /**
+       * @brief Publish the readings accumulated in the specified batch in
+       * its compressed columnar encoding, to the receiver set with
+       * {@link #setSeriesEndpoint}.  Each batch is sent on a connection of
+       * its own, since batches are meant to be published seldom.
+       *
+       * The batch is cleared if the server accepted it or refused the
+       * batch itself (400, 413 or 422), and left unchanged so that it may
+       * be retried otherwise.
+       *
+       * @param batch The batch of readings to publish.
+       * @return Returns \c true if the server accepted the batch.  Returns
+       *   \c false without sending anything if no receiver has been set.
+       */
+      bool publish( SeriesBatch& batch );
+
+      /**
+       * @brief Publish the events held in the store-and-forward queue,
+       * oldest first, and batched if a {@link #setBatchEndpoint batch
+       * endpoint} is set.  Invoked automatically by
+       * {@link #publish(const EventBase&,uint8_t)}.
+       * @return Returns \c true if the queue is now empty.
+       */
+      bool drain();
+
+      /**
+       * @brief Set the wire format in which events are published.  The
+       * default is {@link JsonEncoder}.  Set before publishing, since
+       * events already in the store-and-forward queue are held in the
+       * format they were encoded in.  Batches of queued events are only
+       * sent for encoders that {@link Encoder#supportsBatch support} it.
+       * @param e The encoder to use.  Must outlive the client.
+       */
+      void setEncoder( const Encoder& e ) { encoder = &e; }
+
+      /// Return the encoder used to publish events.
+      const Encoder& getEncoder() const { return *encoder; }
+
+      /// Return the queue of events held while Sidecar is unreachable.
+      /// Use to configure the drop policy or check its state.
+      EventQueue& getQueue() { return queue; }
+
+      /// Return the persistent connection used to publish events.  Use to
+      /// retrieve the connection reuse and reconnect counters.
+      const Connection& getConnection() const { return connection; }
 
       /// Initialise the API with the API key and secret used to sign provisioning requests.
+      /// The HMAC key state for the secret is computed once here and reused
+      /// for every request.
       static void initAPIKey( const QString& apiKey, const QString& apiSecret );
 
       /// Initialise the API with the user key and secret used to sign event requests.
+      /// As with {@link #initAPIKey} only the precomputed HMAC key state is retained.
       static void initUserKey( const QString& userKey, const QString& userSecret );
 
     private:
+      uint16_t post( const EventBase& event, const UUID& id, int64_t timestamp,
+        QString& response );
+
+      uint16_t send( HttpClient& client, const RequestTemplate::Values& values,
+        const EventBase& event, const UUID& id, int64_t timestamp ) const;
+
+      uint16_t post( const RequestTemplate& request, const QString& body,
+        const char* contentType, QString& response );
+
+      uint16_t post( const RequestTemplate& request, std::size_t number,
+        const char* contentType, QString& response );
+
+      uint16_t send( HttpClient& client, const RequestTemplate& request,
+        const RequestTemplate::Values& values, std::size_t number ) const;
+
+      std::size_t next( const RequestTemplate*& request, const char*& contentType ) const;
+
+      void write( qsense::Sink& sink, const RequestTemplate& request,
+        std::size_t number ) const;
+
+      bool batching() const { return batchRequest.getUri().address() != NULL; }
+
+      void sign( HttpRequest& request, const qsense::FlashString& uri,
+        const QString& body, const char* contentType ) const;
+
+      void sign( HttpRequest& request, const qsense::FlashString& uri,
+        const QString& hash, std::size_t length, const char* contentType ) const;
+
       QString md5( const QString& event ) const;
 
       QString signature(
-        const QString& secret,
-        const QString& method,
-        const QString& uri,
+        const hash::Sha1::Key& secret,
+        const qsense::FlashString& method,
+        const qsense::FlashString& uri,
         const QString& date,
         const QString& hash ) const;
+
+    private:
+      Connection connection;
+      EventQueue queue;
+      AsyncRequest request;
+      const Encoder* encoder;
+      PublishCallback callback;
+      void* context;
+      std::size_t queued;
+      uint8_t priority;
+      bool included;
+      RequestTemplate batchRequest;
+      QString seriesServer;
+      const char* seriesUri;
+      uint16_t seriesPort;
     };
 
   } // namespace net
@@ -14,8 +14,11 @@ limitations under the License.
  */
 #include <SimpleSidecarClient.h>
 #include <SidecarClient.h>
+#include <CborEncoder.h>
 #include <DateTime.h>
 #include <QHttpClient.h>
+#include <ArenaEvent.h>
+#include <ReadingFilter.h>
 #include <Event.h>
 #include <UUID.h>
 
@@ -29,11 +32,38 @@ namespace qsense
       return client;
     }
 
-    SimpleSidecarClient() : client(), event() {}
-    void reset() { event = qsense::Event(); }
+    SimpleSidecarClient() : client(), arena( block, sizeof( block ) ), event( arena ),
+      filter(), suppressed( false ) {}
+
+    void reset()
+    {
+      event.clear();
+      suppressed = false;
+    }
+
+    // Nothing to publish if every reading added was suppressed
+    bool unchanged() const { return suppressed && event.numberOfReadings() == 0; }
+
+    // Counts each tag of each key
+    std::size_t keyTagCount() const
+    {
+      std::size_t total = 0;
+      for ( std::size_t i = 0; i < event.numberOfKeyTags(); ++i )
+      {
+        std::size_t count = 0;
+        event.getKeyTags( i, count );
+        total += count;
+      }
+
+      return total;
+    }
 
     qsense::net::SidecarClient client;
-    qsense::Event event;
+    int64_t block[( QSENSE_EVENT_ARENA_SIZE + 7 ) / 8];
+    qsense::Arena arena;
+    qsense::ArenaEvent event;
+    qsense::ReadingFilter filter;
+    bool suppressed;
   };
 }
 
@@ -129,21 +159,66 @@ void SimpleSidecarClient::initEventAPI( const EventAPIData& data )
 }
 
 
-void SimpleSidecarClient::addReading( const String& key, const float value )
+bool SimpleSidecarClient::addReading( const String& key, const float value )
+{
+  qsense::SimpleSidecarClient& instance = qsense::SimpleSidecarClient::getInstance();
+
+  const qsense::Reading reading( key.c_str(), value );
+  if ( ! instance.filter.test( reading ) )
+  {
+    instance.suppressed = true;
+    return true;
+  }
+
+  // A reading dropped from a full event must not become the reference
+  const std::size_t count = instance.event.numberOfReadings();
+  instance.event += reading;
+  if ( instance.event.numberOfReadings() == count ) return false;
+
+  instance.filter.commit( reading );
+  return true;
+}
+
+
+void SimpleSidecarClient::setReadingFilter( const float absolute, const float relative,
+    uint32_t minimumInterval, uint32_t heartbeat )
+{
+  qsense::SimpleSidecarClient::getInstance().filter.setDefault(
+      qsense::ReadingFilter::Settings( absolute, relative, minimumInterval, heartbeat ) );
+}
+
+
+bool SimpleSidecarClient::setReadingFilter( const String& key, const float absolute,
+    const float relative, uint32_t minimumInterval, uint32_t heartbeat )
 {
-  qsense::SimpleSidecarClient::getInstance().event += qsense::Reading( key.c_str(), value );
+  return qsense::SimpleSidecarClient::getInstance().filter.configure( key.c_str(),
+      qsense::ReadingFilter::Settings( absolute, relative, minimumInterval, heartbeat ) );
 }
 
 
-void SimpleSidecarClient::addTag( const String& value )
+uint32_t SimpleSidecarClient::suppressedReadings()
 {
-  qsense::SimpleSidecarClient::getInstance().event += value.c_str();
+  return qsense::SimpleSidecarClient::getInstance().filter.suppressed();
 }
 
 
-void SimpleSidecarClient::addKeyTag( const String& key, const String& tag )
+bool SimpleSidecarClient::addTag( const String& value )
 {
-  qsense::SimpleSidecarClient::getInstance().event.add( key.c_str(), tag.c_str() );
+  qsense::ArenaEvent& event = qsense::SimpleSidecarClient::getInstance().event;
+
+  const std::size_t count = event.numberOfTags();
+  event += value.c_str();
+  return event.numberOfTags() > count;
+}
+
+
+bool SimpleSidecarClient::addKeyTag( const String& key, const String& tag )
+{
+  qsense::ArenaEvent& event = qsense::SimpleSidecarClient::getInstance().event;
+
+  const std::size_t count = qsense::SimpleSidecarClient::getInstance().keyTagCount();
+  event.add( key.c_str(), tag.c_str() );
+  return qsense::SimpleSidecarClient::getInstance().keyTagCount() > count;
 }
 
 
@@ -151,10 +226,88 @@ bool SimpleSidecarClient::publish()
 {
   using qsense::SimpleSidecarClient;
 
+  if ( SimpleSidecarClient::getInstance().unchanged() )
+  {
+    SimpleSidecarClient::getInstance().reset();
+    return true;
+  }
+
+  const bool truncated = SimpleSidecarClient::getInstance().event.isTruncated();
   const bool result = SimpleSidecarClient::getInstance().client.publish(
         SimpleSidecarClient::getInstance().event );
   SimpleSidecarClient::getInstance().reset();
-  return result;
+  return result && ! truncated;
+}
+
+
+bool SimpleSidecarClient::beginPublish()
+{
+  using qsense::SimpleSidecarClient;
+
+  if ( SimpleSidecarClient::getInstance().unchanged() )
+  {
+    SimpleSidecarClient::getInstance().reset();
+    return true;
+  }
+
+  const bool truncated = SimpleSidecarClient::getInstance().event.isTruncated();
+  const bool result = SimpleSidecarClient::getInstance().client.beginPublish(
+        SimpleSidecarClient::getInstance().event );
+  if ( result ) SimpleSidecarClient::getInstance().reset();
+  return result && ! truncated;
+}
+
+
+bool SimpleSidecarClient::poll()
+{
+  return qsense::SimpleSidecarClient::getInstance().client.poll();
+}
+
+
+void SimpleSidecarClient::setEncoding( Encoding encoding )
+{
+  qsense::net::SidecarClient& client = qsense::SimpleSidecarClient::getInstance().client;
+
+  switch ( encoding )
+  {
+    case JSON:
+      client.setEncoder( qsense::JsonEncoder::singleton() );
+      break;
+    case CBOR:
+      client.setEncoder( qsense::CborEncoder::singleton() );
+      break;
+  }
+}
+
+
+void SimpleSidecarClient::setDropPolicy( DropPolicy policy )
+{
+  qsense::SimpleSidecarClient::getInstance().client.getQueue().setDropPolicy(
+      static_cast<qsense::EventQueue::DropPolicy>( policy ) );
+}
+
+
+uint16_t SimpleSidecarClient::pendingEvents()
+{
+  return qsense::SimpleSidecarClient::getInstance().client.getQueue().size();
+}
+
+
+uint32_t SimpleSidecarClient::connectionReuseCount()
+{
+  return qsense::SimpleSidecarClient::getInstance().client.getConnection().reuseCount();
+}
+
+
+uint32_t SimpleSidecarClient::reconnectCount()
+{
+  return qsense::SimpleSidecarClient::getInstance().client.getConnection().reconnectCount();
+}
+
+
+uint16_t SimpleSidecarClient::eventArenaHighWater()
+{
+  return qsense::SimpleSidecarClient::getInstance().arena.getHighWater();
 }
 
 
@@ -17,6 +17,14 @@ limitations under the License.
 
 #include <Arduino.h>
 
+#ifndef QSENSE_EVENT_ARENA_SIZE
+// Number of bytes reserved for the readings and tags of the event being built.
+// Each reading takes 15 bytes on AVR, and the readings are held in an array
+// of 4, 8 or 16 readings, so the default holds about 8 readings and a few
+// short tags.
+#define QSENSE_EVENT_ARENA_SIZE 256
+#endif
+
 /**
  * @brief A simple client implementation that hides the low-level API.
  *
@@ -188,8 +196,39 @@ public:
    *
    * @param key A user defined key for the reading
    * @param value The value for the reading.
+   * @return Returns \c false if the reading did not fit in the
+   *   \c QSENSE_EVENT_ARENA_SIZE bytes reserved for the event and was
+   *   dropped.  A reading suppressed by the reading filter is not dropped.
+   */
+  bool addReading( const String& key, const float value );
+
+  /**
+   * @brief Suppress readings passed to {@link #addReading} that have not
+   * changed enough since the last reading of the same key that was kept.
+   * All readings are kept until a filter is set.
+   *
+   * @param absolute The band within which values are unchanged.
+   * @param relative The band within which values are unchanged, as a
+   *   fraction of the last value kept.  The larger band applies.
+   * @param minimumInterval The milli seconds after a reading was kept
+   *   before another is kept.
+   * @param heartbeat The milli seconds after a reading was kept after
+   *   which another is kept whatever its value, or \c 0 for none.
+   */
+  void setReadingFilter( const float absolute, const float relative = 0,
+    uint32_t minimumInterval = 0, uint32_t heartbeat = 0 );
+
+  /**
+   * @brief Filter the readings of the specified key with settings of its
+   * own, in place of those set for all keys.
+   *
+   * @return Returns \c false if too many keys are filtered already.
    */
-  void addReading( const String& key, const float value );
+  bool setReadingFilter( const String& key, const float absolute,
+    const float relative = 0, uint32_t minimumInterval = 0, uint32_t heartbeat = 0 );
+
+  /// Return the number of readings suppressed by the reading filter.
+  uint32_t suppressedReadings();
 
   /**
    * @brief Add optional tag values to help analyse the event after
@@ -198,8 +237,10 @@ public:
    * \b NOTE: Tags should be single words without spaces.
    *
    * @param value A tag value.
+   * @return Returns \c false if the tag did not fit and was dropped, as
+   *   with {@link #addReading}.
    */
-  void addTag( const String& value );
+  bool addTag( const String& value );
 
   /**
    * @brief Add option key-tag values to help identify/analyse the event
@@ -210,19 +251,81 @@ public:
    *
    * @param key The key for the key-tag pair.
    * @param tag A tag value to associate with the key.
+   * @return Returns \c false if the key-tag did not fit and was dropped,
+   *   as with {@link #addReading}.
    */
-  void addKeyTag( const String& key, const String& tag );
+  bool addKeyTag( const String& key, const String& tag );
 
   /**
    * @brief publish Publish the built up event to the Sidecar Event API.
    * Invoke {@link #addReading} with the individual readings that are
    * part of the current event, and {@link #addTag} as needed to build
-   * up a complete event before publishing to Sidecar.
+   * up a complete event before publishing to Sidecar.  Nothing is sent
+   * if every reading added was suppressed by the reading filter.
    *
-   * @return Returns \c true if publish succeeded.
+   * @return Returns \c true if publish succeeded.  Returns \c false if
+   *   anything added to the event was dropped, after publishing what fit.
    */
   bool publish();
 
+  /**
+   * @brief Start publishing the built up event without blocking the
+   * application loop.  Invoke {@link #poll} from \c loop() until it
+   * returns \c false.  The event is re-initialised as with {@link #publish}.
+   *
+   * @return Returns \c false if a previous publish is still in progress,
+   *   or if anything added to the event was dropped, after starting to
+   *   publish what fit.
+   */
+  bool beginPublish();
+
+  /**
+   * @brief Advance the publish started with {@link #beginPublish}.  Each
+   * call performs one step of the request, as described for
+   * qsense::net::AsyncRequest.
+   *
+   * @return Returns \c true while the publish is in progress.
+   */
+  bool poll();
+
+  /// Enumeration of the wire formats in which events may be published.
+  enum Encoding { JSON = 0, CBOR = 1 };
+
+  /**
+   * @brief Select the wire format in which events are published.  CBOR
+   * events are considerably smaller than JSON.  Select before the first
+   * publish.
+   */
+  void setEncoding( Encoding encoding );
+
+  /// Enumeration of policies used to make room in the queue of events
+  /// held while Sidecar is unreachable.
+  enum DropPolicy { DropOldest = 0, DropNewest = 1, DropLowestPriority = 2 };
+
+  /**
+   * @brief Set the policy used to make room in the queue of events held
+   * while Sidecar is unreachable.  Queued events are published, oldest
+   * first, on the next successful {@link #publish}.
+   */
+  void setDropPolicy( DropPolicy policy );
+
+  /// Return the number of events waiting to be published to Sidecar.
+  uint16_t pendingEvents();
+
+  /// Return the number of publishes that reused the open connection to Sidecar.
+  uint32_t connectionReuseCount();
+
+  /// Return the number of times the connection to Sidecar was re-established.
+  uint32_t reconnectCount();
+
+  /**
+   * @brief Return the most bytes of the \c QSENSE_EVENT_ARENA_SIZE bytes
+   * reserved for the event that any event has used.  Readings and tags
+   * that do not fit are dropped, so print this after a few publishes to
+   * size the arena for the sketch.
+   */
+  uint16_t eventArenaHighWater();
+
   /// Return the current date/time in ISO 8601 format
   const String currentTime();
 
@@ -0,0 +1,48 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "Sink.h"
+
+using qsense::Sink;
+using qsense::SinkBuffer;
+
+
+SinkBuffer::SinkBuffer( Sink& s ) : sink( s )
+{
+  setp( buffer, buffer + bufferSize );
+}
+
+
+SinkBuffer::int_type SinkBuffer::overflow( int_type c )
+{
+  sync();
+
+  if ( ! traits_type::eq_int_type( c, traits_type::eof() ) )
+  {
+    *pptr() = traits_type::to_char_type( c );
+    pbump( 1 );
+  }
+
+  return traits_type::not_eof( c );
+}
+
+
+int SinkBuffer::sync()
+{
+  const std::size_t length = pptr() - pbase();
+  if ( length > 0 ) sink.write( pbase(), length );
+
+  setp( buffer, buffer + bufferSize );
+  return 0;
+}
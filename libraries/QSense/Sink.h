@@ -0,0 +1,123 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef QSENSE_SINK_H
+#define QSENSE_SINK_H
+
+#if defined( ARDUINO )
+#include "QSense.h"
+#include "../StandardCplusplus/ostream"
+#include "../StandardCplusplus/streambuf"
+#else
+#include <QSense.h>
+#include <ostream>
+#include <streambuf>
+#endif
+
+namespace qsense
+{
+  /**
+   * @brief Destination for serialised data.
+   *
+   * Allows data such as events to be serialised directly to where it is
+   * needed (a hash, a socket) without first building it up in memory.
+   */
+  class Sink
+  {
+  public:
+    /// Destructor for sub-classes
+    virtual ~Sink() {}
+
+    /// Consume the specified bytes.
+    virtual void write( const char* data, std::size_t length ) = 0;
+  };
+
+
+  /// A sink that appends to a string.  Used where the serialised data
+  /// has to be retained, such as events queued for later publishing.
+  class StringSink : public Sink
+  {
+  public:
+    /// Create a new sink that appends to the specified string.
+    StringSink( qsense::QString& str ) : string( str ) {}
+
+    void write( const char* data, std::size_t length ) { string.append( data, length ); }
+
+  private:
+    qsense::QString& string;
+  };
+
+
+  /// A sink that writes to an output stream.  Used to serialise through
+  /// a {@link JsonWriter} where a stream is expected.
+  class StreamSink : public Sink
+  {
+  public:
+    /// Create a new sink that writes to the specified stream.
+    StreamSink( std::ostream& os ) : stream( os ) {}
+
+    void write( const char* data, std::size_t length ) { stream.write( data, length ); }
+
+  private:
+    std::ostream& stream;
+  };
+
+
+  /**
+   * @brief A stream buffer that forwards all output to a {@link Sink}.
+   *
+   * Output is staged in a small fixed size buffer so that the sink
+   * receives data in chunks rather than one token at a time.  Use with
+   * a \c std::ostream to reuse the existing \c operator<< serialisers:
+   *
+   * \code
+   * SinkBuffer buffer( sink );
+   * std::ostream os( &buffer );
+   * os << event;
+   * os.flush();
+   * \endcode
+   *
+   * Binary encoders such as {@link CborEncoder} and the request head of a
+   * {@link net::RequestTemplate} write bytes with \c sputc and \c sputn
+   * directly, which only store into the staged buffer and do no stream
+   * formatting.
+   */
+  class SinkBuffer : public std::streambuf
+  {
+  public:
+    /// Number of bytes staged before they are passed to the sink.
+    static const std::size_t bufferSize = 64;
+
+    /// Create a new buffer that forwards to the specified sink.
+    SinkBuffer( Sink& sink );
+
+    /// Destructor.  Forwards any staged output to the sink.
+    ~SinkBuffer() { sync(); }
+
+  protected:
+    int_type overflow( int_type c );
+    int sync();
+
+  private:
+    SinkBuffer( const SinkBuffer& );
+    SinkBuffer& operator = ( const SinkBuffer& );
+
+  private:
+    Sink& sink;
+    char buffer[bufferSize];
+  };
+
+} // namespace qsense
+
+#endif // QSENSE_SINK_H
@@ -0,0 +1,239 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef QSENSE_STATICEVENT_H
+#define QSENSE_STATICEVENT_H
+
+#if defined( ARDUINO )
+#include "Event.h"
+#else
+#include <Event.h>
+#endif
+
+namespace qsense
+{
+  /**
+   * @brief An event with a capacity fixed at compile time, for firmware
+   * that must not use the heap while building events.
+   *
+   * Readings, tags and key-tags are held in arrays within the object, so
+   * the footprint of the event is known at compile time and adding to it
+   * never allocates.  Readings with string values still copy the string,
+   * and reading keys are interned the first time they are seen, as with
+   * {@link Event}.  Tags and keys of key-tags are copied into a character
+   * array within the object.  Items added beyond the capacity are dropped,
+   * and {@link #isTruncated} reports that the event is incomplete:
+   *
+   * \code
+   * qsense::StaticEvent<4> event;
+   * event += qsense::Reading( "temperature", 21.5f );
+   * event.add( "temperature", "celsius" );
+   * client.publish( event );
+   * \endcode
+   *
+   * Each of the first three capacities must be from \c 1 to \c 255.
+   *
+   * @tparam MaxReadings The maximum number of readings.
+   * @tparam MaxTags The maximum number of tags.
+   * @tparam MaxKeyTags The maximum number of key-tags, counting each
+   *   tag of each key.
+   * @tparam TextSize The bytes for the text of tags and keys, counting a
+   *   terminating nul for each.  A key used more than once is held once.
+   */
+  template <uint8_t MaxReadings, uint8_t MaxTags = 4, uint8_t MaxKeyTags = 4,
+    uint16_t TextSize = 64>
+  class StaticEvent : public EventBase
+  {
+  public:
+    /// Default constructor.  Uses default location set through {@link Event#init}
+    StaticEvent() : EventBase(), textSize( 0 ), readingCount( 0 ),
+      tagCount( 0 ), keyTagCount( 0 ) {}
+
+    /// Create a new event with the specified location
+    StaticEvent( const Location& loc ) : EventBase( loc ), textSize( 0 ),
+      readingCount( 0 ), tagCount( 0 ), keyTagCount( 0 ) {}
+
+    /// Add the specified reading to this event.  Ignored if the event is
+    /// full or its key could not be interned.
+    StaticEvent& add( const Reading& reading )
+    {
+      if ( readingCount < MaxReadings && reading.getKeySymbol().isValid() )
+      {
+        readings[readingCount++] = reading;
+      }
+      else truncated = true;
+
+      return *this;
+    }
+
+    /// Add the specified tag to this event.  Ignored if the event is full.
+    StaticEvent& add( const char* tag ) { return addTag( tag, strlen( tag ) ); }
+
+    /// Add the specified tag to this event.  Ignored if the event is full.
+    StaticEvent& add( const QString& tag ) { return addTag( tag.data(), tag.size() ); }
+
+    /// Add the specified key-tag to this event.  Ignored if the event is full.
+    StaticEvent& add( const char* key, const char* tag )
+    {
+      return addKeyTag( key, strlen( key ), tag, strlen( tag ) );
+    }
+
+    /// Add the specified key-tag to this event.  Ignored if the event is full.
+    StaticEvent& add( const QString& key, const QString& tag )
+    {
+      return addKeyTag( key.data(), key.size(), tag.data(), tag.size() );
+    }
+
+    /// Operator for adding a reading to the event
+    StaticEvent& operator += ( const Reading& reading ) { return add( reading ); }
+
+    /// Operator for adding a tag to the event.
+    StaticEvent& operator += ( const char* tag ) { return add( tag ); }
+
+    /// Operator for adding a tag to the event.
+    StaticEvent& operator += ( const QString& tag ) { return add( tag ); }
+
+    /// Remove all readings, tags and key-tags, to reuse the event.
+    void clear()
+    {
+      textSize = 0;
+      readingCount = 0;
+      tagCount = 0;
+      keyTagCount = 0;
+      truncated = false;
+    }
+
+    std::size_t numberOfReadings() const { return readingCount; }
+
+    const Reading& getReading( std::size_t index ) const { return readings[index]; }
+
+    std::size_t numberOfTags() const { return tagCount; }
+
+    const char* getTag( std::size_t index ) const { return text + tags[index]; }
+
+    std::size_t numberOfKeyTags() const
+    {
+      std::size_t count = 0;
+      for ( uint8_t i = 0; i < keyTagCount; ++i )
+      {
+        if ( i == 0 || keyTagKeys[i] != keyTagKeys[i - 1] ) ++count;
+      }
+
+      return count;
+    }
+
+    const char* getKeyTags( std::size_t index, std::size_t& count ) const
+    {
+      const uint8_t start = startOf( index );
+      uint8_t end = start + 1;
+      while ( end < keyTagCount && keyTagKeys[end] == keyTagKeys[start] ) ++end;
+
+      count = end - start;
+      return text + keyTagKeys[start];
+    }
+
+    const char* getKeyTag( std::size_t index, std::size_t position ) const
+    {
+      return text + keyTagTags[startOf( index ) + position];
+    }
+
+  private:
+    StaticEvent& addTag( const char* tag, std::size_t length )
+    {
+      if ( tagCount < MaxTags && copy( tag, length, tags[tagCount] ) ) ++tagCount;
+      else truncated = true;
+
+      return *this;
+    }
+
+    StaticEvent& addKeyTag( const char* key, std::size_t keyLength,
+      const char* tag, std::size_t tagLength )
+    {
+      // A key already present is held once, so keys compare by offset
+      uint16_t keyOffset = TextSize;
+      uint8_t position = keyTagCount;
+      for ( uint8_t i = keyTagCount; i > 0; --i )
+      {
+        const char* existing = text + keyTagKeys[i - 1];
+        if ( strncmp( existing, key, keyLength ) == 0 && existing[keyLength] == 0 )
+        {
+          keyOffset = keyTagKeys[i - 1];
+          position = i;
+          break;
+        }
+      }
+
+      // Undo a key copied for a tag that did not fit
+      const uint16_t size = textSize;
+      uint16_t tagOffset = 0;
+      if ( keyTagCount >= MaxKeyTags ||
+          ( keyOffset == TextSize && ! copy( key, keyLength, keyOffset ) ) ||
+          ! copy( tag, tagLength, tagOffset ) )
+      {
+        textSize = size;
+        truncated = true;
+        return *this;
+      }
+
+      // Tags of the same key are kept together, after the last one added
+
+      for ( uint8_t i = keyTagCount; i > position; --i )
+      {
+        keyTagKeys[i] = keyTagKeys[i - 1];
+        keyTagTags[i] = keyTagTags[i - 1];
+      }
+
+      keyTagKeys[position] = keyOffset;
+      keyTagTags[position] = tagOffset;
+      ++keyTagCount;
+      return *this;
+    }
+
+    bool copy( const char* data, std::size_t length, uint16_t& offset )
+    {
+      if ( length >= std::size_t( TextSize - textSize ) ) return false;
+
+      memcpy( text + textSize, data, length );
+      text[textSize + length] = 0;
+      offset = textSize;
+      textSize += length + 1;
+      return true;
+    }
+
+    uint8_t startOf( std::size_t index ) const
+    {
+      uint8_t start = 0;
+      while ( index > 0 )
+      {
+        if ( ++start == keyTagCount || keyTagKeys[start] != keyTagKeys[start - 1] ) --index;
+      }
+
+      return start;
+    }
+
+  private:
+    Reading readings[MaxReadings];
+    char text[TextSize];
+    uint16_t textSize;
+    uint16_t tags[MaxTags];
+    uint16_t keyTagKeys[MaxKeyTags];
+    uint16_t keyTagTags[MaxKeyTags];
+    uint8_t readingCount;
+    uint8_t tagCount;
+    uint8_t keyTagCount;
+  };
+
+} // namespace qsense
+
+#endif // QSENSE_STATICEVENT_H
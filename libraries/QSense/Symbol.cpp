@@ -0,0 +1,82 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "Symbol.h"
+
+#if defined( ARDUINO )
+#include "../StandardCplusplus/vector"
+#include "../StandardCplusplus/cstring"
+#else
+#include <cstring>
+#include <vector>
+#endif
+
+namespace qsense
+{
+  namespace data
+  {
+    /// Strings indexed by symbol identifier
+    static std::vector<qsense::QString>& symbols()
+    {
+      static std::vector<qsense::QString> table;
+      return table;
+    }
+  }
+}
+
+using qsense::QString;
+using qsense::Symbol;
+
+
+Symbol::Symbol( const char* text ) : id( intern( text, strlen( text ) ) ) {}
+
+
+const QString& Symbol::str() const
+{
+  static const QString empty;
+  return isValid() ? data::symbols()[id] : empty;
+}
+
+
+std::size_t Symbol::count()
+{
+  return data::symbols().size();
+}
+
+
+Symbol::Id Symbol::intern( const char* text, std::size_t length )
+{
+  std::vector<QString>& table = data::symbols();
+
+  // Few distinct keys are expected, a linear scan is enough
+  for ( std::size_t i = 0; i < table.size(); ++i )
+  {
+    const QString& symbol = table[i];
+    if ( symbol.size() == length && memcmp( symbol.data(), text, length ) == 0 )
+    {
+      return Id( i );
+    }
+  }
+
+  if ( table.size() >= QSENSE_SYMBOLS ) return invalid;
+
+  table.push_back( QString( text, length ) );
+  return Id( table.size() - 1 );
+}
+
+
+std::ostream& qsense::operator << ( std::ostream& os, const Symbol& symbol )
+{
+  return os << symbol.str();
+}
@@ -0,0 +1,101 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef QSENSE_SYMBOL_H
+#define QSENSE_SYMBOL_H
+
+#if defined( ARDUINO )
+#include "QSense.h"
+#include "../StandardCplusplus/ostream"
+#else
+#include <QSense.h>
+#include <ostream>
+#endif
+
+#ifndef QSENSE_SYMBOLS
+// Maximum number of distinct reading keys
+#if defined( ARDUINO )
+#define QSENSE_SYMBOLS 32
+#else
+#define QSENSE_SYMBOLS 4096
+#endif
+#endif
+
+namespace qsense
+{
+  /**
+   * @brief A reading key, interned in a process wide table.
+   *
+   * Each distinct string is stored once, and symbols are small integer
+   * identifiers into the table.  Creating, copying and comparing symbols
+   * does not allocate, and the string is only looked up when an event is
+   * serialised.  Strings are never removed from the table, so keys should
+   * come from a small fixed set, and tags, which may change with every
+   * event, are copied into the event instead.  Once \c QSENSE_SYMBOLS
+   * strings have been interned, symbols for new strings are not valid.
+   * Readings with such keys are dropped when added to an event, which
+   * reports it through {@link EventBase#isTruncated}.
+   */
+  class Symbol
+  {
+  public:
+    /// Type of the identifier into the table.
+    typedef uint16_t Id;
+
+    /// Identifier of a symbol that could not be interned.
+    static const Id invalid = 0xFFFF;
+
+    /// Default constructor.  Creates an invalid symbol.
+    Symbol() : id( invalid ) {}
+
+    /// Create the symbol for the string, interning it if necessary.
+    Symbol( const qsense::QString& text ) : id( intern( text.data(), text.size() ) ) {}
+
+    /// Create the symbol for the null terminated string.
+    Symbol( const char* text );
+
+    /// Return the identifier into the table.
+    Id getId() const { return id; }
+
+    /// Return \c true if the string was interned.
+    bool isValid() const { return id != invalid; }
+
+    /// Return the string.  Empty if the symbol is not valid.
+    const qsense::QString& str() const;
+
+    /// Symbols are equal if they are for the same string.
+    bool operator == ( const Symbol& other ) const { return id == other.id; }
+
+    /// Symbols are equal if they are for the same string.
+    bool operator != ( const Symbol& other ) const { return id != other.id; }
+
+    /// Orders symbols by the time at which they were interned.
+    bool operator < ( const Symbol& other ) const { return id < other.id; }
+
+    /// Return the number of strings interned.
+    static std::size_t count();
+
+  private:
+    static Id intern( const char* text, std::size_t length );
+
+  private:
+    Id id;
+  };
+
+  /// Write the string of the symbol to the output stream.
+  std::ostream& operator << ( std::ostream& os, const Symbol& symbol );
+
+} // namespace qsense
+
+#endif // QSENSE_SYMBOL_H
@@ -0,0 +1,112 @@
+/*
+Copyright 2015 Sidecar
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+/*
+Host check that events in flight survive the queue filling up behind them,
+under every drop policy.  Build and run from the library directory with:
+
+    g++ -DQSENSE_EVENT_QUEUE_SIZE=256 -I. \
+      extras/EventQueueTest.cpp EventQueue.cpp Sink.cpp && ./a.out
+*/
+#include <cstdio>
+#include <EventQueue.h>
+
+using qsense::EventQueue;
+using qsense::QString;
+
+namespace data
+{
+  int failures = 0;
+
+  void check( bool condition, const char* message )
+  {
+    if ( condition ) return;
+    std::printf( "FAIL: %s\n", message );
+    ++failures;
+  }
+
+
+  QString event( int id )
+  {
+    char buffer[32];
+    std::snprintf( buffer, sizeof( buffer ), "{\"event\": %04d}", id );
+    return QString( buffer );
+  }
+
+
+  /// Pin two events as a request would, then fill the queue behind them.
+  void fill( EventQueue::DropPolicy policy, bool delivered )
+  {
+    EventQueue queue( policy );
+    queue.push( event( 0 ), 0 );
+    queue.push( event( 1 ), 0 );
+    queue.pin( 2 );
+
+    for ( int i = 2; i < 200; ++i ) queue.push( event( i ), uint8_t( i % 5 ) );
+
+    check( queue.dropped() > 0, "queue did not fill" );
+    check( queue.pinned() == 2, "pinned count changed" );
+
+    QString front;
+    queue.peek( 0, front );
+    check( front == event( 0 ), "first event in flight was dropped" );
+    queue.peek( 1, front );
+    check( front == event( 1 ), "second event in flight was dropped" );
+
+    const std::size_t size = queue.size();
+    queue.release( delivered );
+    check( queue.pinned() == 0, "events still pinned after release" );
+    check( queue.size() == ( delivered ? size - 2 : size ),
+        "release removed the wrong number of events" );
+
+    queue.peek( 0, front );
+    if ( delivered ) check( front != event( 0 ) && front != event( 1 ),
+        "delivered events left in the queue" );
+    else check( front == event( 0 ), "failed events not kept" );
+  }
+
+
+  /// With every event in flight, a new event is the only one dropped.
+  void full()
+  {
+    EventQueue queue;
+    int pushed = 0;
+    while ( queue.dropped() == 0 ) queue.push( event( pushed++ ) );
+
+    queue.clear();
+    for ( int i = 0; i < pushed - 1; ++i ) queue.push( event( i ) );
+    queue.pin( queue.size() );
+    const std::size_t size = queue.size();
+
+    check( ! queue.push( event( pushed ) ), "push succeeded into a pinned queue" );
+    check( queue.size() == size, "pinned event dropped from a full queue" );
+  }
+}
+
+
+int main()
+{
+  const EventQueue::DropPolicy policies[] = {
+    EventQueue::DropOldest, EventQueue::DropNewest, EventQueue::DropLowestPriority };
+
+  for ( std::size_t i = 0; i < sizeof( policies ) / sizeof( policies[0] ); ++i )
+  {
+    data::fill( policies[i], true );
+    data::fill( policies[i], false );
+  }
+  data::full();
+
+  if ( data::failures == 0 ) std::printf( "OK\n" );
+  return data::failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,214 @@
+#!/usr/bin/env python3
+#
+# Copyright 2015 Sidecar
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""
+Local stand-in for the Sidecar event ingestion API.
+
+Accepts events published with either the JSON or the CBOR encoder,
+batches of events, and batches of readings published with SeriesBatch
+(decoded by series.py), on any path, checks the Content-Length and
+Content-MD5 headers, decodes the body and prints each event as JSON.
+Connections are kept alive between requests, as with Sidecar.
+
+Point a client at it with SidecarClient( "<host>", 8080 ), and give
+setBatchEndpoint and setSeriesEndpoint a path to send batches, e.g.:
+
+    python3 ingest_server.py --port 8080
+    python3 ingest_server.py --port 8080 --status 503   # exercise queueing
+
+Only the standard library is required.
+"""
+
+import argparse
+import hashlib
+import json
+import struct
+import sys
+import uuid
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+import series
+
+# Integer keys used by CborEncoder (see CborEncoder.h)
+EVENT_FIELDS = {0: "id", 1: "deviceId", 2: "ts", 3: "stream",
+                4: "location", 5: "readings", 6: "tags", 7: "keyTags"}
+READING_FIELDS = {0: "key", 1: "ts", 2: "value"}
+
+
+class CborDecoder:
+    """Minimal RFC 7049 decoder covering the types CborEncoder emits."""
+
+    def __init__(self, data):
+        self.data = data
+        self.offset = 0
+
+    def take(self, count):
+        if self.offset + count > len(self.data):
+            raise ValueError("truncated CBOR data")
+        chunk = self.data[self.offset:self.offset + count]
+        self.offset += count
+        return chunk
+
+    def argument(self, info):
+        if info < 24:
+            return info
+        if info == 24:
+            return self.take(1)[0]
+        if info == 25:
+            return struct.unpack(">H", self.take(2))[0]
+        if info == 26:
+            return struct.unpack(">I", self.take(4))[0]
+        if info == 27:
+            return struct.unpack(">Q", self.take(8))[0]
+        raise ValueError("unsupported additional information %d" % info)
+
+    def decode(self):
+        initial = self.take(1)[0]
+        major, info = initial >> 5, initial & 0x1F
+
+        if major == 0:
+            return self.argument(info)
+        if major == 1:
+            return -1 - self.argument(info)
+        if major == 2:
+            return bytes(self.take(self.argument(info)))
+        if major == 3:
+            return self.take(self.argument(info)).decode("utf-8")
+        if major == 4:
+            return [self.decode() for _ in range(self.argument(info))]
+        if major == 5:
+            result = {}
+            for _ in range(self.argument(info)):
+                key = self.decode()
+                result[key] = self.decode()
+            return result
+        if major == 6:
+            tag = self.argument(info)
+            value = self.decode()
+            if tag == 37:
+                return uuid.UUID(bytes=value)
+            return value
+        if info == 20:
+            return False
+        if info == 21:
+            return True
+        if info == 22:
+            return None
+        if info == 25:
+            return struct.unpack(">e", self.take(2))[0]
+        if info == 26:
+            return struct.unpack(">f", self.take(4))[0]
+        if info == 27:
+            return struct.unpack(">d", self.take(8))[0]
+        raise ValueError("unsupported simple value %d" % info)
+
+
+def decode_cbor(data):
+    decoder = CborDecoder(data)
+    value = decoder.decode()
+    if decoder.offset != len(data):
+        raise ValueError("%d trailing bytes" % (len(data) - decoder.offset))
+    return value
+
+
+def expand_event(event):
+    """Map the integer keys of a CBOR event to the JSON field names."""
+    result = {}
+    for key, value in event.items():
+        name = EVENT_FIELDS.get(key, key)
+        if name == "readings":
+            value = [{READING_FIELDS.get(k, k): v for k, v in r.items()}
+                     for r in value]
+            # Readings taken at the time of the event omit the timestamp
+            for reading in value:
+                reading.setdefault("ts", event.get(2))
+        elif name == "location":
+            value = {"lat": value[0], "lon": value[1]}
+        elif name == "keyTags":
+            value = [{"key": k, "tags": v} for k, v in value.items()]
+        result[name] = value
+    return result
+
+
+def default(value):
+    if isinstance(value, uuid.UUID):
+        return str(value)
+    raise TypeError(repr(value))
+
+
+class IngestHandler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    status = 202
+
+    def respond(self, code, message=""):
+        body = message.encode("utf-8")
+        self.send_response(code)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def do_POST(self):
+        length = int(self.headers.get("Content-Length", "0"))
+        body = self.rfile.read(length)
+
+        digest = hashlib.md5(body).hexdigest()
+        expected = self.headers.get("Content-MD5", "")
+        if expected.lower() != digest:
+            self.log_message("Content-MD5 mismatch: %s != %s", expected, digest)
+            self.respond(400, '{"error": "Content-MD5 mismatch"}')
+            return
+
+        content_type = self.headers.get("Content-Type", "")
+        try:
+            if content_type.startswith("application/cbor"):
+                events = [expand_event(decode_cbor(body))]
+            elif content_type.startswith(series.CONTENT_TYPE):
+                events = [series.decode(body)]
+            else:
+                document = json.loads(body.decode("utf-8"))
+                events = document.get("events", [document])
+        except ValueError as error:
+            self.log_message("Undecodable %s body: %s", content_type, error)
+            self.respond(400, '{"error": "undecodable body"}')
+            return
+
+        self.log_message("%s %s, %d bytes, %d event(s)",
+                         self.path, content_type, length, len(events))
+        for event in events:
+            print(json.dumps(event, default=default, sort_keys=True))
+        sys.stdout.flush()
+
+        self.respond(self.status)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--host", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--status", type=int, default=202,
+                        help="response code to return for valid events")
+    args = parser.parse_args()
+
+    IngestHandler.status = args.status
+    server = ThreadingHTTPServer((args.host, args.port), IngestHandler)
+    print("Listening on %s:%d" % (args.host, args.port))
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
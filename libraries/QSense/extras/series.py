@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+#
+# Copyright 2015 Sidecar
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""
+Reference decoder for the columnar encoding written by SeriesBatch.
+
+The format is described in SeriesBatch.h.  Decode a body captured to a
+file and print it as JSON with:
+
+    python3 series.py batch.bin
+
+Only the standard library is required.
+"""
+
+import json
+import struct
+import sys
+import uuid
+
+CONTENT_TYPE = "application/x-qsense-series"
+VERSION = 1
+
+
+class BitReader:
+    """Reads big-endian bit fields from a bytes object."""
+
+    def __init__(self, data):
+        self.data = data
+        self.offset = 0
+
+    def read(self, bits):
+        value = 0
+        for _ in range(bits):
+            index = self.offset >> 3
+            if index >= len(self.data):
+                raise ValueError("series truncated")
+            bit = (self.data[index] >> (7 - (self.offset & 7))) & 1
+            value = (value << 1) | bit
+            self.offset += 1
+        return value
+
+    def signed(self, bits):
+        value = self.read(bits)
+        return value - (1 << bits) if value & (1 << (bits - 1)) else value
+
+    def prefix(self, limit):
+        """Count the leading one bits, up to limit."""
+        count = 0
+        while count < limit and self.read(1):
+            count += 1
+        return count
+
+
+class ByteReader:
+    def __init__(self, data):
+        self.data = data
+        self.offset = 0
+
+    def take(self, count):
+        if self.offset + count > len(self.data):
+            raise ValueError("unexpected end of batch")
+        chunk = self.data[self.offset:self.offset + count]
+        self.offset += count
+        return chunk
+
+    def varint(self):
+        value = 0
+        shift = 0
+        while True:
+            byte = self.take(1)[0]
+            value |= (byte & 0x7F) << shift
+            if byte < 0x80:
+                return value
+            shift += 7
+
+    def text(self):
+        return self.take(self.varint()).decode("utf-8")
+
+
+# Width of the delta of delta for each count of leading one bits
+DOD_BITS = {1: 7, 2: 9, 3: 12, 4: 32}
+
+
+def to_float(bits):
+    return struct.unpack(">f", struct.pack(">I", bits))[0]
+
+
+def decode_series(bits, points):
+    """Yield the (timestamp, value) pairs of one series."""
+    reader = BitReader(bits)
+    timestamp = reader.signed(64)
+    value = reader.read(32)
+    yield timestamp, to_float(value)
+
+    delta = 0
+    leading = length = 0
+    for _ in range(points - 1):
+        prefix = reader.prefix(4)
+        if prefix:
+            delta += reader.signed(DOD_BITS[prefix])
+        timestamp += delta
+
+        if reader.read(1):
+            if reader.read(1):
+                leading = reader.read(5)
+                length = reader.read(5) + 1
+            value ^= reader.read(length) << (32 - leading - length)
+        yield timestamp, to_float(value)
+
+
+def decode(data):
+    """Decode a batch to an event holding every reading."""
+    reader = ByteReader(data)
+    if reader.take(2) != b"QS":
+        raise ValueError("not a series batch")
+    version = reader.take(1)[0]
+    if version != VERSION:
+        raise ValueError("unsupported version %d" % version)
+
+    event = {"deviceId": uuid.UUID(bytes=reader.take(16)),
+             "stream": reader.text()}
+    latitude, longitude = struct.unpack(">ff", reader.take(8))
+    event["location"] = {"lat": latitude, "lon": longitude}
+
+    readings = []
+    for _ in range(reader.varint()):
+        key = reader.text()
+        points = reader.varint()
+        bits = reader.take(reader.varint())
+        for timestamp, value in decode_series(bits, points):
+            readings.append({"key": key, "ts": timestamp, "value": value})
+    event["readings"] = readings
+
+    if reader.offset != len(data):
+        raise ValueError("%d trailing bytes" % (len(data) - reader.offset))
+    return event
+
+
+def main():
+    with open(sys.argv[1], "rb") as source:
+        event = decode(source.read())
+    print(json.dumps(event, default=str, indent=2, sort_keys=True))
+
+
+if __name__ == "__main__":
+    main()